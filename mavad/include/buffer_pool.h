@@ -0,0 +1,101 @@
+/**
+ * @brief Pool of reusable byte buffers for the packet send/receive paths
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @namespace rnl
+ */
+namespace rnl {
+
+    /**
+     * @brief Pool of byte buffers that keep their capacity between uses. \n
+     * Buffers are handed out as a Lease and return to the pool when the lease
+     * goes out of scope. Once every buffer has grown to the largest frame, acquiring
+     * one does no heap allocation. The pool counts its allocations so this can be
+     * checked at the end of a run. \n
+     * Not thread safe, owned and used by a single DroneSoc on the simulator thread.
+     */
+    class BufferPool
+    {
+        struct Slot
+        {
+            std::string buf; /**< The buffer, cleared on acquire */
+            size_t      cap; /**< Capacity of buf when it was handed out */
+        };
+
+        public:
+            /**
+             * @brief Allocation counters of the pool
+             */
+            struct Stats
+            {
+                uint64_t acquired    = 0; /**< Number of leases handed out */
+                uint64_t allocations = 0; /**< Heap allocations: new buffers plus buffers that grew while leased */
+                size_t   buffers     = 0; /**< Buffers owned by the pool */
+            };
+
+            /**
+             * @brief Exclusive use of one buffer of the pool, returned on destruction
+             */
+            class Lease
+            {
+                public:
+                    Lease (BufferPool* pool, Slot* slot);
+                    Lease (Lease&& other);
+                    Lease (const Lease&) = delete;
+                    Lease& operator= (const Lease&) = delete;
+                    ~Lease ();
+
+                    std::string* get () const { return &slot->buf; }
+                    std::string* operator-> () const { return &slot->buf; }
+                    std::string& operator* () const { return slot->buf; }
+
+                    /**
+                     * @brief Bytes of the buffer, as expected by ns3::Packet
+                     */
+                    const uint8_t* data () const { return reinterpret_cast<const uint8_t*> (slot->buf.data ()); }
+
+                private:
+                    BufferPool* pool;
+                    Slot*       slot;
+            };
+
+            /**
+             * @brief Construct a new Buffer Pool object
+             *
+             * @param reserve Initial capacity (bytes) of every new buffer, should cover the usual frame
+             */
+            explicit BufferPool (size_t reserve = 256);
+
+            /**
+             * @brief Take an empty buffer out of the pool, allocating one only if none is free
+             *
+             * @return Lease Lease on the buffer
+             */
+            Lease acquire ();
+
+            /**
+             * @brief Allocation counters of the pool
+             */
+            const Stats& stats () const;
+
+        private:
+            /**
+             * @brief Return a buffer to the pool, counting it if it had to grow
+             *
+             * @param slot Slot of the buffer
+             */
+            void release (Slot* slot);
+
+            size_t                             reserve_bytes; /**< Initial capacity of new buffers */
+            std::vector<std::unique_ptr<Slot>> slots; /**< Every buffer owned by the pool */
+            std::vector<Slot*>                 free_slots; /**< Buffers not currently leased */
+            Stats                              st; /**< Allocation counters */
+    };
+};
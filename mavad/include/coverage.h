@@ -0,0 +1,147 @@
+/**
+ * @brief Boustrophedon coverage of a polygon, split across the scanners of a cluster
+ */
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+#include "trajectory.h"
+
+/**
+ * @namespace rnl
+ */
+namespace rnl {
+
+    /**
+     * @brief Coverage paths of the scanning drones and their coverage rate. \n
+     * The area is cut into lanes parallel to the x axis, width apart, each lane the part of
+     * a scan line inside the polygon (even-odd rule, so holes and concave sides cut a line
+     * into several lanes). The lanes are dealt out bottom up, in contiguous bands of about
+     * the same length, to the scanners sorted by y, and each scanner flies its band back and
+     * forth. \n
+     * A path is computed once per assignment: a lead-in from where the drone is to its first
+     * lane, then the cycle over its lanes and back to the first one, which the planner
+     * replays as long as the drone scans @see Planner::replayCoverage
+     */
+    class Coverage
+    {
+        public:
+            using Polygon = std::vector<ns3::Vector3D>;
+
+            /**
+             * @brief One lane, the part of a scan line inside the area
+             */
+            struct Lane
+            {
+                double y; /**< Scan line */
+                double x0; /**< Start of the lane, x0 < x1 */
+                double x1; /**< End of the lane */
+            };
+
+            /**
+             * @brief Construct a new Coverage object
+             *
+             * @param width distance (m) between two lanes, the swath of a scanner
+             */
+            Coverage (double width = 1.0);
+
+            /**
+             * @brief Parse a polygon written as x,y pairs separated by semicolons, eg 0,0;4,0;4,3
+             *
+             * @param text vertices in order
+             * @param area parsed polygon, z is 0
+             * @return false if the text is malformed or has fewer than 3 vertices
+             */
+            static bool parsePolygon (const std::string& text, Polygon* area);
+
+            void setWidth (double width);
+            double width () const;
+
+            /**
+             * @brief Lanes of an area, by y then x. An area thinner than width gets a single
+             * scan line through its middle
+             *
+             * @param area vertices of the polygon, in order, z is ignored
+             * @param width distance (m) between two lanes
+             */
+            static std::vector<Lane> lanes (const Polygon& area, double width);
+
+            /**
+             * @brief Split an area across scanners and build the path of each. Replaces any
+             * earlier assignment of these drones
+             *
+             * @param area vertices of the polygon, in order
+             * @param ids IDs of the scanners
+             * @param from current position of each scanner, its height is the scan height
+             * @param now simulation time (s) of the assignment
+             */
+            void assign (const Polygon& area, const std::vector<int>& ids,
+                         const std::vector<ns3::Vector3D>& from, double now);
+
+            /**
+             * @brief Whether the drone has a coverage path
+             */
+            bool assigned (int id) const;
+
+            /**
+             * @brief Whether the drone has at least one lane to scan
+             */
+            bool scans (int id) const;
+
+            /**
+             * @brief Coverage path of a drone: lead-in, then the cycle. Must be assigned
+             */
+            const rnl::Trajectory& path (int id) const;
+
+            /**
+             * @brief Arc length along path (id) where the cycle starts
+             */
+            double cycleStart (int id) const;
+
+            /**
+             * @brief Drones with a coverage path, in ID order
+             */
+            const std::vector<int>& scanners () const;
+
+            /**
+             * @brief Count one cycle of a drone as flown
+             *
+             * @param id ID of the drone
+             * @param now simulation time (s)
+             */
+            void lapDone (int id, double now);
+
+            /**
+             * @brief Write one row per drone: lanes, area and path per cycle, cycles flown, time
+             * to the first full cycle and coverage rate, the area swept per second since the
+             * assignment up to its last cycle
+             *
+             * @param path output CSV
+             */
+            void report (const std::string& path) const;
+
+        private:
+            /**
+             * @brief Assignment of one scanner
+             */
+            struct Plan
+            {
+                rnl::Trajectory traj; /**< Lead-in and cycle */
+                double          cycle_s0; /**< Arc length where the cycle starts */
+                int             lanes; /**< Lanes of the cycle */
+                double          scan_len; /**< Length (m) of its lanes */
+                double          assigned; /**< Simulation time (s) of the assignment */
+                double          first_lap; /**< Simulation time (s) the first cycle ended, -1 before */
+                double          last_lap; /**< Simulation time (s) the last cycle ended, -1 before */
+                int             laps; /**< Cycles flown */
+            };
+
+            double             sweep; /**< Distance (m) between two lanes */
+            std::map<int, Plan> plans; /**< Assignment of each scanner, by ID */
+            std::vector<int>   scanner_ids; /**< Keys of plans, sorted */
+    };
+};
@@ -0,0 +1,205 @@
+/**
+ * @brief Transition table of the drone state machine and its counters
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "planner_config.h"
+
+/**
+ * @namespace rnl
+ */
+namespace rnl {
+
+    /**
+     * @enum FsmPhase
+     * @brief Phase of a drone, from the bits of its msg_send.state @see fsmPhase
+     */
+    enum class FsmPhase : uint8_t
+    {
+        FREE, /**< Following, relaying or flying to the site */
+        CHANGING_PARENT, /**< SCHANGEPAR, moving up to a new parent */
+        ANCHORING, /**< SANCHORING, flying to its slot next to a centre */
+        SETTLED, /**< SSITEREACHED, holding its slot or scanning */
+        COUNT
+    };
+
+    /**
+     * @enum FsmEvent
+     * @brief What a drone reacts to: a control command of its parent, reaching its slot, or
+     * for a centre the state of its cluster @see Planner::updateCentre
+     */
+    enum class FsmEvent : uint8_t
+    {
+        HOLD_RC, /**< CHOLDRC */
+        CHANGE_PARENT, /**< CCHANGEPAR */
+        RECRUIT_RIGHT, /**< CRTOP */
+        RECRUIT_LEFT, /**< CLTOP */
+        RECRUIT_BEHIND, /**< CBTOP */
+        SLOT_REACHED, /**< An arm is within the tolerance of its slot @see Formation::tolerance */
+        CENTRE_ARRIVED, /**< A centre is within the tolerance of its slot for the first time */
+        KID_PENDING, /**< A centre has a child left to recruit */
+        CLUSTER_COMPLETE, /**< The last centre has recruited all its children */
+        RELAY, /**< Any other centre has recruited all its children, nothing requested */
+        RELAY_REQUEST, /**< Any other centre has recruited all its children, a drone is requested */
+        COUNT
+    };
+
+    /**
+     * @enum FsmAction
+     * @brief What the planner does on a transition @see Planner::runAction
+     */
+    enum class FsmAction : uint8_t
+    {
+        NONE, /**< The event is ignored in this phase */
+        HOLD_RC, /**< Close up to RC from the parent */
+        CHANGE_PARENT, /**< Move up to the new parent and start relaying for it */
+        ANCHOR_RIGHT, /**< Fly to the right arm slot of the recruiting centre */
+        ANCHOR_LEFT, /**< Fly to the left arm slot of the recruiting centre */
+        ANCHOR_BEHIND, /**< Fly to the next centre slot behind the recruiting centre */
+        SETTLE_ARM, /**< Hold the slot and report to the centre */
+        CENTRE_ARRIVE, /**< Settle on the centre slot and start recruiting with the first child */
+        RECRUIT_KID, /**< Hold the slot and command the child being recruited */
+        HOLD_CLUSTER, /**< Hold the slot, relay to the cluster and start the scans once */
+        RELAY, /**< Hold the slot and relay to the cluster */
+        FORWARD_REQUEST /**< Hold the slot and pass the request on towards the base */
+    };
+
+    /**
+     * @brief One row of the transition table
+     */
+    struct FsmTransition
+    {
+        FsmPhase  from;
+        FsmEvent  event;
+        FsmAction action;
+    };
+
+    constexpr int FSM_PHASES = static_cast<int> (FsmPhase::COUNT);
+    constexpr int FSM_EVENTS = static_cast<int> (FsmEvent::COUNT);
+
+    /**
+     * @brief Every transition of the drone state machine, any pair not listed is ignored
+     */
+    constexpr FsmTransition FSM_TRANSITIONS[] = {
+        {FsmPhase::FREE,            FsmEvent::HOLD_RC,          FsmAction::HOLD_RC},
+        {FsmPhase::FREE,            FsmEvent::CHANGE_PARENT,    FsmAction::CHANGE_PARENT},
+        {FsmPhase::FREE,            FsmEvent::RECRUIT_RIGHT,    FsmAction::ANCHOR_RIGHT},
+        {FsmPhase::FREE,            FsmEvent::RECRUIT_LEFT,     FsmAction::ANCHOR_LEFT},
+        {FsmPhase::FREE,            FsmEvent::RECRUIT_BEHIND,   FsmAction::ANCHOR_BEHIND},
+        {FsmPhase::FREE,            FsmEvent::SLOT_REACHED,     FsmAction::SETTLE_ARM},
+        {FsmPhase::CHANGING_PARENT, FsmEvent::HOLD_RC,          FsmAction::HOLD_RC},
+        {FsmPhase::CHANGING_PARENT, FsmEvent::RECRUIT_RIGHT,    FsmAction::ANCHOR_RIGHT},
+        {FsmPhase::CHANGING_PARENT, FsmEvent::RECRUIT_LEFT,     FsmAction::ANCHOR_LEFT},
+        {FsmPhase::CHANGING_PARENT, FsmEvent::RECRUIT_BEHIND,   FsmAction::ANCHOR_BEHIND},
+        {FsmPhase::CHANGING_PARENT, FsmEvent::SLOT_REACHED,     FsmAction::SETTLE_ARM},
+        {FsmPhase::ANCHORING,       FsmEvent::SLOT_REACHED,     FsmAction::SETTLE_ARM},
+        {FsmPhase::SETTLED,         FsmEvent::SLOT_REACHED,     FsmAction::SETTLE_ARM},
+        {FsmPhase::FREE,            FsmEvent::CENTRE_ARRIVED,   FsmAction::CENTRE_ARRIVE},
+        {FsmPhase::CHANGING_PARENT, FsmEvent::CENTRE_ARRIVED,   FsmAction::CENTRE_ARRIVE},
+        {FsmPhase::ANCHORING,       FsmEvent::CENTRE_ARRIVED,   FsmAction::CENTRE_ARRIVE},
+        {FsmPhase::SETTLED,         FsmEvent::KID_PENDING,      FsmAction::RECRUIT_KID},
+        {FsmPhase::SETTLED,         FsmEvent::CLUSTER_COMPLETE, FsmAction::HOLD_CLUSTER},
+        {FsmPhase::SETTLED,         FsmEvent::RELAY,            FsmAction::RELAY},
+        {FsmPhase::SETTLED,         FsmEvent::RELAY_REQUEST,    FsmAction::FORWARD_REQUEST},
+    };
+
+    /**
+     * @brief Control bit raising each command event, in the order a drone handles them
+     */
+    constexpr std::pair<FsmEvent, int> FSM_COMMANDS[] = {
+        {FsmEvent::HOLD_RC,        CHOLDRC},
+        {FsmEvent::CHANGE_PARENT,  CCHANGEPAR},
+        {FsmEvent::RECRUIT_RIGHT,  CRTOP},
+        {FsmEvent::RECRUIT_LEFT,   CLTOP},
+        {FsmEvent::RECRUIT_BEHIND, CBTOP},
+    };
+
+    using FsmTable = std::array<std::array<FsmAction, FSM_EVENTS>, FSM_PHASES>;
+
+    /**
+     * @brief Dense phase x event table of FSM_TRANSITIONS, built at compile time
+     */
+    constexpr FsmTable fsmTable ()
+    {
+        FsmTable _t {};
+        for (const FsmTransition& _tr : FSM_TRANSITIONS)
+        {
+            _t[static_cast<int> (_tr.from)][static_cast<int> (_tr.event)] = _tr.action;
+        }
+        return _t;
+    }
+
+    constexpr FsmTable FSM_TABLE = fsmTable ();
+
+    /**
+     * @brief Action of an event in a phase, NONE if the phase ignores it
+     */
+    constexpr FsmAction fsmLookup (FsmPhase phase, FsmEvent event)
+    {
+        return FSM_TABLE[static_cast<int> (phase)][static_cast<int> (event)];
+    }
+
+    /**
+     * @brief Phase of a drone from its state bits. SSITEREACHED wins over SANCHORING, which
+     * wins over SCHANGEPAR
+     */
+    constexpr FsmPhase fsmPhase (int state)
+    {
+        return (state & SSITEREACHED) ? FsmPhase::SETTLED
+             : (state & SANCHORING)   ? FsmPhase::ANCHORING
+             : (state & SCHANGEPAR)   ? FsmPhase::CHANGING_PARENT
+             : FsmPhase::FREE;
+    }
+
+    static_assert (fsmLookup (FsmPhase::CHANGING_PARENT, FsmEvent::CHANGE_PARENT) == FsmAction::NONE,
+                   "a drone changing parent ignores another CCHANGEPAR");
+    static_assert (fsmLookup (FsmPhase::ANCHORING, FsmEvent::RECRUIT_LEFT) == FsmAction::NONE,
+                   "an anchoring drone ignores recruit commands");
+    static_assert (fsmLookup (FsmPhase::SETTLED, FsmEvent::CENTRE_ARRIVED) == FsmAction::NONE,
+                   "a centre arrives once");
+
+    const char* fsmName (FsmPhase phase);
+    const char* fsmName (FsmEvent event);
+
+    /**
+     * @brief Number and run time of the transitions taken, per phase and event
+     */
+    class FsmStats
+    {
+        public:
+            /**
+             * @brief Construct a new Fsm Stats object, all zero
+             */
+            FsmStats ();
+
+            /**
+             * @brief Count one transition
+             *
+             * @param phase phase it was taken in
+             * @param event event that fired it
+             * @param seconds wall clock time of its action
+             */
+            void record (FsmPhase phase, FsmEvent event, double seconds);
+
+            /**
+             * @brief Transitions taken from phase on event
+             */
+            uint64_t count (FsmPhase phase, FsmEvent event) const;
+
+            /**
+             * @brief Write one row per transition of the table: phase, event, count, total and mean time
+             *
+             * @param path output CSV
+             */
+            void write (const std::string& path) const;
+
+        private:
+            std::array<std::array<uint64_t, FSM_EVENTS>, FSM_PHASES> counts; /**< Transitions taken */
+            std::array<std::array<double, FSM_EVENTS>, FSM_PHASES>   seconds; /**< Wall clock time of their actions */
+    };
+};
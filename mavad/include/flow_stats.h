@@ -0,0 +1,92 @@
+/**
+ * @brief Per flow throughput and delay statistics from the ns-3 FlowMonitor
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/flow-monitor-helper.h"
+#include "ns3/ipv4-flow-classifier.h"
+
+/**
+ * @namespace rnl
+ */
+namespace rnl {
+
+    /**
+     * @brief Installs FlowMonitor on every node, snapshots the counters of every flow at
+     * a fixed interval and writes them out at the end of the run. \n
+     * Flows are tagged by their destination port: the unicast/broadcast control messages
+     * (UDP 9), the TCP offload (8080) and the UDP offload (8081). \n
+     * Three files are written: a summary CSV with one row per flow, a snapshot CSV with
+     * the cumulative counters of every flow at each snapshot, and a JSON file with the
+     * summary plus the delay histogram of every flow.
+     */
+    class FlowStats
+    {
+        public:
+            /**
+             * @brief Cumulative counters of one flow at one snapshot
+             */
+            struct Snapshot
+            {
+                double    t; /**< Time of the snapshot (s) */
+                uint32_t  flow; /**< Flow ID */
+                uint32_t  tx_packets; /**< Packets sent */
+                uint32_t  rx_packets; /**< Packets received */
+                uint32_t  lost_packets; /**< Packets declared lost */
+                uint64_t  rx_bytes; /**< Bytes received */
+                double    delay_sum; /**< Sum of the delays (s) */
+                double    jitter_sum; /**< Sum of the jitters (s) */
+            };
+
+            /**
+             * @brief Construct a new Flow Stats object, nothing is installed
+             */
+            FlowStats ();
+
+            /**
+             * @brief Install the monitor on all nodes and start the snapshots
+             *
+             * @param interval time between two snapshots
+             */
+            void install (ns3::Time interval);
+
+            /**
+             * @brief Whether install was called
+             */
+            bool installed () const;
+
+            /**
+             * @brief Take a snapshot of every flow and schedule the next one
+             */
+            void snapshot ();
+
+            /**
+             * @brief Take a last snapshot and write the summary CSV, snapshot CSV and JSON files
+             *
+             * @param prefix path prefix, the files are prefix.csv, prefix_snapshots.csv and prefix.json
+             */
+            void write (const std::string& prefix);
+
+            /**
+             * @brief Kind of traffic of a flow, from its protocol and destination port
+             */
+            static std::string flowKind (uint8_t protocol, uint16_t port);
+
+        private:
+            /**
+             * @brief Append the current counters of every flow to snapshots
+             */
+            void take ();
+
+            ns3::FlowMonitorHelper     helper; /**< Owns the probes and the classifier */
+            ns3::Ptr<ns3::FlowMonitor> monitor; /**< Monitor of all nodes */
+            ns3::Time                  interval; /**< Time between two snapshots */
+            std::vector<Snapshot>      snapshots; /**< Every snapshot of every flow, in time order */
+    };
+};
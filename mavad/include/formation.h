@@ -0,0 +1,178 @@
+/**
+ * @brief Formation slot table: where every drone of a swarm of any size goes over the site
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+#include "planner_config.h"
+
+/**
+ * @namespace rnl
+ */
+namespace rnl {
+
+    /**
+     * @brief Slot table generated from a formation spec. \n
+     * The swarm forms clusters: a centre and its arms. The leader (ID 0) is the first
+     * centre; every centre recruits its arms and then the next centre, which recruits
+     * its own arms and so on. IDs follow the recruit order, so the unicast chain of the
+     * recruitment is simply ID order. \n
+     * The last two nodes get no slot: the tail, a relay that holds RC from the drone in
+     * front of it, and the base node. Any further drones without a slot follow as relays. \n
+     * Shapes, with spacing RC between neighbours:
+     * - T: centres in a line away from the site, one arm on each side (the pci t_formation)
+     * - LINE: centres only
+     * - GRID: centres in a line, a configurable number of arms on each side
+     * - RING: centres on a circle around the site, one arm outward and one inward; the
+     *   inward arms are spacing apart, so the centres are a little more
+     * No two slots are closer than spacing
+     */
+    class Formation
+    {
+        public:
+            /**
+             * @enum Shape
+             * @brief Formation spec
+             */
+            enum class Shape
+            {
+                T,
+                LINE,
+                GRID,
+                RING
+            };
+
+            /**
+             * @brief Construct a new Formation object
+             *
+             * @param shape formation spec
+             * @param num_nodes nodes of the swarm, with the tail and the base node
+             * @param arms arms on each side of a centre, only used by GRID
+             * @param spacing distance between neighbouring slots
+             */
+            Formation (Shape shape = Shape::T, int num_nodes = 8, int arms = 2, double spacing = rnl::RC);
+
+            /**
+             * @brief Parse a shape name: t, line, grid or ring
+             *
+             * @param name name of the shape
+             * @param shape parsed shape
+             * @return false if the name is unknown
+             */
+            static bool parseShape (const std::string& name, Shape* shape);
+
+            /**
+             * @brief Drones with a slot, IDs 0..numSlots()-1
+             */
+            int numSlots () const;
+
+            /**
+             * @brief First drone without a slot, the tail of the swarm
+             */
+            int tailId () const;
+
+            /**
+             * @brief Index of the base node, the last node
+             */
+            int baseId () const;
+
+            bool hasSlot (int id) const;
+            bool isCentre (int id) const;
+            bool isArm (int id) const;
+
+            /**
+             * @brief Centre of the cluster of a drone, -1 without a slot
+             */
+            int centreOf (int id) const;
+
+            /**
+             * @brief Side of an arm, +1 left, -1 right, 0 for a centre
+             */
+            int side (int id) const;
+
+            /**
+             * @brief Centre recruited before this one, -1 for the leader
+             */
+            int prevCentre (int centre) const;
+
+            /**
+             * @brief Centre this one recruits after its arms, -1 for the last centre
+             */
+            int nextCentre (int centre) const;
+
+            /**
+             * @brief Every centre in recruit order
+             */
+            const std::vector<int>& centres () const;
+
+            /**
+             * @brief Drones a centre recruits, in order: its arms, then the next centre
+             */
+            const std::vector<int>& children (int centre) const;
+
+            /**
+             * @brief Control command a centre sends to recruit a drone: CLTOP and CRTOP for
+             * left and right arms, CBTOP for the next centre
+             */
+            int recruitControl (int id) const;
+
+            /**
+             * @brief Slot of a drone relative to the site centre
+             */
+            ns3::Vector3D offset (int id) const;
+
+            /**
+             * @brief Slot of a drone relative to the slot of the centre that recruits it
+             */
+            ns3::Vector3D offsetFromParent (int id) const;
+
+            /**
+             * @brief Absolute slot of a drone
+             *
+             * @param id ID of the drone, must have a slot
+             * @param site centre of the site
+             */
+            ns3::Vector3D slotPos (int id, const ns3::Vector3D& site) const;
+
+            /**
+             * @brief Distance (m) from its slot within which a drone has reached it: tuned per
+             * drone for the first six slots of T, SITE_TOL otherwise, 0 without a slot
+             */
+            double tolerance (int id) const;
+
+            /**
+             * @brief Whether a drone is within tolerance (id) of its slot, false without a slot
+             */
+            bool siteReached (const ns3::Vector3D& pos, int id, const ns3::Vector3D& site) const;
+
+            /**
+             * @brief Next hop from a node towards the base node: arms go through the inner
+             * arm and their centre, centres through the next centre, the last centre
+             * through the tail relays
+             */
+            int towardBase (int id) const;
+
+        private:
+            /**
+             * @brief Entry of the slot table
+             */
+            struct Slot
+            {
+                ns3::Vector3D offset; /**< Relative to the site centre */
+                int           centre; /**< Centre of the cluster */
+                int           side; /**< +1 left arm, -1 right arm, 0 centre */
+                int           inner; /**< Arm next to this one towards the centre, the centre for the first arm */
+                double        tol; /**< Distance (m) from the slot that counts as reached */
+            };
+
+            std::vector<Slot>             slots; /**< Slot of every drone with one, by ID */
+            std::vector<int>              centre_ids; /**< Centres in recruit order */
+            std::vector<std::vector<int>> kids; /**< Children of each centre, indexed like centre_ids */
+            std::vector<int>              centre_idx; /**< Index into centre_ids of each centre, -1 for arms */
+            int                           num_nodes; /**< Nodes of the swarm */
+    };
+};
@@ -0,0 +1,518 @@
+/**
+ * @brief Wire codecs for the messages exchanged between drones. \n
+ * A message type declares its fields once, as a rnl::Schema specialization holding
+ * a tuple of member pointers. The templates in rnl::codec then generate the binary
+ * and text serializers, the parsers, the encoded size and field-wise equality for it,
+ * so the sending and receiving side of a message can not drift apart. \n
+ *
+ * Adding a message type: \n
+ * 1. Declare the struct with the fields \n
+ * 2. Specialize rnl::Schema with a unique type character and the member pointers \n
+ * 3. Use codec::serialize to send it and codec::parseBody to receive it \n
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include "ns3/core-module.h"
+
+/**
+ * @namespace rnl
+ */
+namespace rnl {
+    static std::string DELIM           = "\n"; /** Delimiter used for serializing message to stringstream @see rnl::codec::serialize() */
+    static std::string DELIM_POS       = ":"; /** Delimiter seperating coordinate value of robot pose @see rnl::codec::toVec*/
+    static uint8_t     WIRE_MAGIC      = 0xFA; /** First byte of every binary frame, never a valid first byte of a text frame @see rnl::WireFormat */
+    static uint8_t     WIRE_VERSION    = 3; /** Version of the binary frame layout, bumped whenever the layout changes */
+
+    /**
+     * @enum WireFormat
+     * @brief Encoding used by rnl::codec::serialize. \n
+     * The receiver detects the format of each frame from its first byte, so nodes
+     * with different settings still understand each other. \n
+     *
+     * * TEXT   - type, then every field of the schema in order, rnl::DELIM seperated and '\0' terminated. \n
+     *            Human readable in pcap traces. Kept for debugging \n
+     * * BINARY - magic(u8) version(u8) type(u8), then every field of the schema in order, packed little-endian: \n
+     *            int -> i32, double -> f64, ns3::Vector3D -> 3 x f64, std::string -> len(u16) bytes \n
+     */
+    enum class WireFormat
+    {
+        TEXT,
+        BINARY
+    };
+
+    extern WireFormat  WIRE_FORMAT; /** Wire format used by the serializers, defaults to WireFormat::BINARY */
+
+    /**
+     * @enum ParseStatus
+     * @brief Result of parsing a received frame. Parsers never throw, a frame that
+     * is not OK leaves the message in an unspecified but valid state
+     */
+    enum class ParseStatus
+    {
+        OK,
+        EMPTY,          // NOTHING TO PARSE
+        TRUNCATED,      // FRAME ENDS BEFORE ITS LAST FIELD
+        BAD_VERSION,    // BINARY FRAME WITH UNKNOWN WIRE_VERSION
+        BAD_TYPE,       // UNKNOWN MESSAGE TYPE
+        BAD_FIELD       // FIELD IS NOT A VALID NUMBER
+    };
+
+    /**
+     * @brief Field list of a message, specialized once per message type as \n
+     * static constexpr char type = 'x'; \n
+     * static constexpr auto fields = std::make_tuple (&Msg::a, &Msg::b, ...); \n
+     *
+     * @tparam M Message type
+     */
+    template <class M>
+    struct Schema;
+
+    /**
+     * @namespace codec
+     */
+    namespace codec {
+
+        /* Little-endian writers for the binary wire format, independent of host byte order */
+        inline void putU8 (std::string* b, uint8_t v)
+        {
+            b->push_back (static_cast<char> (v));
+        }
+
+        inline void putU16 (std::string* b, uint16_t v)
+        {
+            b->push_back (static_cast<char> (v & 0xFF));
+            b->push_back (static_cast<char> ((v >> 8) & 0xFF));
+        }
+
+        inline void putI32 (std::string* b, int32_t v)
+        {
+            uint32_t u = static_cast<uint32_t> (v);
+            for (int k = 0; k < 4; ++k)
+                b->push_back (static_cast<char> ((u >> (8 * k)) & 0xFF));
+        }
+
+        inline void putF64 (std::string* b, double v)
+        {
+            uint64_t u;
+            std::memcpy (&u, &v, sizeof (u));
+            for (int k = 0; k < 8; ++k)
+                b->push_back (static_cast<char> ((u >> (8 * k)) & 0xFF));
+        }
+
+        /* LEB128 varint, 7 bits per byte, high bit set on all but the last byte */
+        inline void putVarint (std::string* b, uint64_t v)
+        {
+            while (v >= 0x80)
+            {
+                b->push_back (static_cast<char> ((v & 0x7F) | 0x80));
+                v >>= 7;
+            }
+            b->push_back (static_cast<char> (v));
+        }
+
+        /* Zigzag maps small signed values to small unsigned ones: 0,-1,1,-2 -> 0,1,2,3 */
+        inline uint64_t zigzag (int64_t v)
+        {
+            return (static_cast<uint64_t> (v) << 1) ^ static_cast<uint64_t> (v >> 63);
+        }
+
+        inline int64_t unzigzag (uint64_t v)
+        {
+            return static_cast<int64_t> (v >> 1) ^ -static_cast<int64_t> (v & 1);
+        }
+
+        /**
+         * @brief Sequential reader over a binary frame. Reading past the end
+         * clears ok and yields zeros, so a frame is checked once after all fields
+         */
+        struct BinReader
+        {
+            const uint8_t* p;
+            size_t         len;
+            size_t         off;
+            bool           ok;
+
+            const uint8_t* take (size_t n)
+            {
+                static const uint8_t zeros[8] = {};
+                if (!ok || n > len - off)
+                {
+                    ok = false;
+                    return zeros;
+                }
+                const uint8_t* r = p + off;
+                off += n;
+                return r;
+            }
+
+            uint8_t  u8  () { return *take (1); }
+
+            uint16_t u16 ()
+            {
+                const uint8_t* q = take (2);
+                return static_cast<uint16_t> (q[0] | (q[1] << 8));
+            }
+
+            int32_t  i32 ()
+            {
+                const uint8_t* q = take (4);
+                uint32_t u = 0;
+                for (int k = 0; k < 4; ++k)
+                    u |= static_cast<uint32_t> (q[k]) << (8 * k);
+                return static_cast<int32_t> (u);
+            }
+
+            double   f64 ()
+            {
+                const uint8_t* q = take (8);
+                uint64_t u = 0;
+                for (int k = 0; k < 8; ++k)
+                    u |= static_cast<uint64_t> (q[k]) << (8 * k);
+                double v;
+                std::memcpy (&v, &u, sizeof (v));
+                return v;
+            }
+
+            uint64_t varint ()
+            {
+                uint64_t v = 0;
+                for (int shift = 0; shift < 64; shift += 7)
+                {
+                    uint8_t b = u8 ();
+                    v |= static_cast<uint64_t> (b & 0x7F) << shift;
+                    if (!(b & 0x80))
+                        return v;
+                }
+                ok = false;
+                return 0;
+            }
+        };
+
+        /**
+         * @brief Sequential tokenizer over a text frame. Each call to next () yields
+         * the view up to the following delimiter; asking for a token after the last
+         * one clears ok
+         */
+        struct TextReader
+        {
+            std::string_view msg;
+            size_t           off;
+            bool             ok;
+
+            std::string_view next (std::string_view delim)
+            {
+                if (!ok || off > msg.size ())
+                {
+                    ok = false;
+                    return {};
+                }
+                size_t _end = msg.find (delim, off);
+                if (_end == std::string_view::npos)
+                    _end = msg.size ();
+                std::string_view _tok = msg.substr (off, _end - off);
+                off = _end + delim.size ();
+                return _tok;
+            }
+        };
+
+        inline bool toInt (std::string_view tok, int* out)
+        {
+            size_t k = 0;
+            bool   neg = false;
+            if (k < tok.size () && (tok[k] == '-' || tok[k] == '+'))
+            {
+                neg = tok[k] == '-';
+                ++k;
+            }
+            if (k == tok.size ())
+                return false;
+
+            long v = 0;
+            for (; k < tok.size (); ++k)
+            {
+                if (tok[k] < '0' || tok[k] > '9')
+                    return false;
+                v = v * 10 + (tok[k] - '0');
+                if (v > 0x7FFFFFFF)
+                    return false;
+            }
+            *out = static_cast<int> (neg ? -v : v);
+            return true;
+        }
+
+        inline bool toDouble (std::string_view tok, double* out)
+        {
+            /* strtod needs a terminated string, tokens are short so copy to the stack */
+            char _buf[64];
+            if (tok.empty () || tok.size () >= sizeof (_buf))
+                return false;
+            std::memcpy (_buf, tok.data (), tok.size ());
+            _buf[tok.size ()] = '\0';
+            char* _end;
+            *out = std::strtod (_buf, &_end);
+            return _end == _buf + tok.size ();
+        }
+
+        inline bool toVec (std::string_view tok, ns3::Vector3D* out)
+        {
+            TextReader _r {tok, 0, true};
+            bool _ok = toDouble (_r.next (rnl::DELIM_POS), &out->x);
+            _ok      = toDouble (_r.next (rnl::DELIM_POS), &out->y) && _ok;
+            _ok      = toDouble (_r.next (rnl::DELIM_POS), &out->z) && _ok;
+            return _ok && _r.ok;
+        }
+
+        /**
+         * @brief Codec of a single field type, specialized for every type a Schema may use
+         *
+         * @tparam T Field type
+         */
+        template <class T>
+        struct Field;
+
+        template <>
+        struct Field<int>
+        {
+            static void   put     (std::string* b, int v)           { putI32 (b, v); }
+            static void   get     (BinReader& r, int& v)            { v = r.i32 (); }
+            static size_t size    (int)                             { return 4; }
+            static void   putText (std::ostream& o, int v)          { o << v; }
+            static bool   getText (std::string_view t, int& v)      { return toInt (t, &v); }
+            static bool   equal   (int a, int b)                    { return a == b; }
+        };
+
+        template <>
+        struct Field<double>
+        {
+            static void   put     (std::string* b, double v)        { putF64 (b, v); }
+            static void   get     (BinReader& r, double& v)         { v = r.f64 (); }
+            static size_t size    (double)                          { return 8; }
+            static void   putText (std::ostream& o, double v)       { o << std::fixed << v; }
+            static bool   getText (std::string_view t, double& v)   { return toDouble (t, &v); }
+            static bool   equal   (double a, double b)              { return a == b; }
+        };
+
+        template <>
+        struct Field<ns3::Vector3D>
+        {
+            static void put (std::string* b, const ns3::Vector3D& v)
+            {
+                putF64 (b, v.x);
+                putF64 (b, v.y);
+                putF64 (b, v.z);
+            }
+
+            static void get (BinReader& r, ns3::Vector3D& v)
+            {
+                v.x = r.f64 ();
+                v.y = r.f64 ();
+                v.z = r.f64 ();
+            }
+
+            static size_t size    (const ns3::Vector3D&)                     { return 24; }
+            static void   putText (std::ostream& o, const ns3::Vector3D& v)  { o << std::fixed << v; }
+            static bool   getText (std::string_view t, ns3::Vector3D& v)     { return toVec (t, &v); }
+
+            static bool equal (const ns3::Vector3D& a, const ns3::Vector3D& b)
+            {
+                return a.x == b.x && a.y == b.y && a.z == b.z;
+            }
+        };
+
+        /* Strings are length prefixed in binary, so they may hold any byte. In text they must not contain rnl::DELIM */
+        template <>
+        struct Field<std::string>
+        {
+            static void put (std::string* b, const std::string& v)
+            {
+                uint16_t _len = static_cast<uint16_t> (std::min<size_t> (v.size (), 0xFFFF));
+                putU16 (b, _len);
+                b->append (v, 0, _len);
+            }
+
+            static void get (BinReader& r, std::string& v)
+            {
+                uint16_t       _len = r.u16 ();
+                const uint8_t* _p   = r.take (_len);
+                if (r.ok)
+                    v.assign (reinterpret_cast<const char*> (_p), _len);
+            }
+
+            static size_t size    (const std::string& v)                     { return 2 + std::min<size_t> (v.size (), 0xFFFF); }
+            static void   putText (std::ostream& o, const std::string& v)    { o << v; }
+
+            static bool getText (std::string_view t, std::string& v)
+            {
+                v.assign (t.data (), t.size ());
+                return true;
+            }
+
+            static bool equal (const std::string& a, const std::string& b)  { return a == b; }
+        };
+
+        template <class T>
+        using FieldOf = Field<std::remove_cv_t<std::remove_reference_t<T>>>;
+
+        /**
+         * @brief Append the fields of m to b in binary
+         */
+        template <class M>
+        void encode (const M& m, std::string* b)
+        {
+            std::apply ([&] (auto... mp) { (FieldOf<decltype (m.*mp)>::put (b, m.*mp), ...); }, Schema<M>::fields);
+        }
+
+        /**
+         * @brief Read the fields of m from r, check r.ok afterwards
+         */
+        template <class M>
+        void decode (M& m, BinReader& r)
+        {
+            std::apply ([&] (auto... mp) { (FieldOf<decltype (m.*mp)>::get (r, m.*mp), ...); }, Schema<M>::fields);
+        }
+
+        /**
+         * @brief Number of bytes encode will append for m
+         */
+        template <class M>
+        size_t encodedSize (const M& m)
+        {
+            return std::apply ([&] (auto... mp) { return (size_t {0} + ... + FieldOf<decltype (m.*mp)>::size (m.*mp)); },
+                               Schema<M>::fields);
+        }
+
+        /**
+         * @brief Field-wise equality of two messages
+         */
+        template <class M>
+        bool equal (const M& a, const M& b)
+        {
+            return std::apply ([&] (auto... mp) { return (true && ... && FieldOf<decltype (a.*mp)>::equal (a.*mp, b.*mp)); },
+                               Schema<M>::fields);
+        }
+
+        /**
+         * @brief Write the fields of m to o, each preceded by rnl::DELIM
+         */
+        template <class M>
+        void encodeText (const M& m, std::ostream& o)
+        {
+            std::apply ([&] (auto... mp) { ((o << rnl::DELIM, FieldOf<decltype (m.*mp)>::putText (o, m.*mp)), ...); },
+                        Schema<M>::fields);
+        }
+
+        /**
+         * @brief Read the fields of m from r, check r.ok afterwards
+         *
+         * @return false if a field is not a valid value
+         */
+        template <class M>
+        bool decodeText (M& m, TextReader& r)
+        {
+            return std::apply ([&] (auto... mp) { return (true && ... && FieldOf<decltype (m.*mp)>::getText (r.next (rnl::DELIM), m.*mp)); },
+                               Schema<M>::fields);
+        }
+
+        /**
+         * @brief Serialize m as a complete frame in rnl::WIRE_FORMAT
+         *
+         * @param m message
+         * @param loc Pointer to string to which this needs to be serialized, previous content is replaced
+         */
+        template <class M>
+        void serialize (const M& m, std::string* loc)
+        {
+            if (rnl::WIRE_FORMAT == rnl::WireFormat::BINARY)
+            {
+                loc->clear ();
+                loc->reserve (3 + encodedSize (m));
+                putU8 (loc, rnl::WIRE_MAGIC);
+                putU8 (loc, rnl::WIRE_VERSION);
+                putU8 (loc, static_cast<uint8_t> (Schema<M>::type));
+                encode (m, loc);
+                return;
+            }
+
+            std::stringstream _msg;
+            _msg << Schema<M>::type;
+            encodeText (m, _msg);
+            _msg << '\0';
+            *loc = _msg.str ();
+        }
+
+        /**
+         * @brief Frame type of a received frame without parsing it
+         *
+         * @param data received frame
+         * @param len length of the frame in bytes
+         * @return type character of the frame's Schema, '\0' if unknown
+         */
+        inline char frameType (const uint8_t* data, size_t len)
+        {
+            if (len >= 3 && data[0] == rnl::WIRE_MAGIC)
+                return static_cast<char> (data[2]);
+            if (len >= 1 && data[0] != rnl::WIRE_MAGIC)
+                return static_cast<char> (data[0]);
+            return '\0';
+        }
+
+        /**
+         * @brief Parse a complete frame of type M written by serialize
+         *
+         * @param m message to fill
+         * @param data received frame, its type must be Schema<M>::type
+         * @param len length of the frame in bytes
+         * @return ParseStatus::OK on success, the reason of failure otherwise
+         */
+        template <class M>
+        ParseStatus parseBody (M& m, const uint8_t* data, size_t len)
+        {
+            if (!len)
+                return rnl::ParseStatus::EMPTY;
+
+            if (data[0] == rnl::WIRE_MAGIC)
+            {
+                BinReader r {data, len, 0, true};
+                r.u8 ();
+                uint8_t _version = r.u8 ();
+                char    _type    = static_cast<char> (r.u8 ());
+                if (!r.ok)
+                    return rnl::ParseStatus::TRUNCATED;
+                if (_version != rnl::WIRE_VERSION)
+                    return rnl::ParseStatus::BAD_VERSION;
+                if (_type != Schema<M>::type)
+                    return rnl::ParseStatus::BAD_TYPE;
+
+                decode (m, r);
+                return r.ok ? rnl::ParseStatus::OK : rnl::ParseStatus::TRUNCATED;
+            }
+
+            /* Text frames are always terminated by '\0', without it the last field may be cut */
+            std::string_view _msg (reinterpret_cast<const char*> (data), len);
+            if (_msg.back () != '\0')
+                return rnl::ParseStatus::TRUNCATED;
+            while (_msg.size () && _msg.back () == '\0')
+                _msg.remove_suffix (1);
+
+            TextReader r {_msg, 0, true};
+            if (r.next (rnl::DELIM) != std::string_view (&Schema<M>::type, 1))
+                return rnl::ParseStatus::BAD_TYPE;
+
+            bool _ok = decodeText (m, r);
+            if (!r.ok)
+                return rnl::ParseStatus::TRUNCATED;
+            return _ok ? rnl::ParseStatus::OK : rnl::ParseStatus::BAD_FIELD;
+        }
+    };
+};
@@ -0,0 +1,177 @@
+/**
+ * @brief Bulk data offload of the scanning drones to the base node, with goodput accounting
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/packet-sink.h"
+#include "ns3/packet-sink-helper.h"
+#include "ns3/bulk-send-helper.h"
+#include "ns3/on-off-helper.h"
+#include "ns3/seq-ts-size-header.h"
+
+/**
+ * @namespace rnl
+ */
+namespace rnl {
+
+    /**
+     * @brief Sends the data a drone collects to the sink on the base node and measures
+     * how it gets there. \n
+     * A job is one transfer: an image, a chunk of video or a telemetry session. Per job the
+     * completion time is recorded; per drone and over the swarm the goodput and the
+     * queueing delay (time from the application writing a segment to the sink reading it,
+     * taken from the SeqTsSizeHeader of the segment). \n
+     * The jobs of a drone do not overlap in time, so received bytes fill its oldest
+     * incomplete job first.
+     */
+    class Offload
+    {
+        public:
+            /**
+             * @enum Payload
+             * @brief What the drones send
+             */
+            enum class Payload
+            {
+                IMAGERY,    // IMAGES OF image_bytes, ONE EVERY image_period, SENT AS FAST AS POSSIBLE
+                VIDEO,      // A STREAM PACED AT video_rate FOR video_duration
+                TELEMETRY   // telemetry_bytes EVERY telemetry_period FOR telemetry_duration
+            };
+
+            /**
+             * @brief Workload and transport of the offload
+             */
+            struct Config
+            {
+                Payload         payload            = Payload::IMAGERY; /**< Payload model */
+                bool            tcp                = true; /**< TCP if true, UDP otherwise */
+                std::string     tcp_cc             = "ns3::TcpNewReno"; /**< TCP congestion control (ns3::TcpL4Protocol::SocketType) */
+                uint32_t        segment            = 536; /**< Segment (TCP) or datagram (UDP) size in bytes */
+                uint32_t        image_bytes        = 536*20; /**< Size of one image */
+                uint32_t        images             = 1; /**< Images per job round */
+                double          image_period       = 20.0; /**< Seconds between two images of a round */
+                std::string     video_rate         = "500kbps"; /**< Rate of the video stream */
+                double          video_duration     = 10.0; /**< Seconds of video per job */
+                uint32_t        telemetry_bytes    = 64; /**< Size of one telemetry record */
+                double          telemetry_period   = 1.0; /**< Seconds between two telemetry records */
+                double          telemetry_duration = 60.0; /**< Seconds of telemetry per job */
+            };
+
+            /**
+             * @brief One transfer from a drone to the sink
+             */
+            struct Job
+            {
+                int       drone; /**< Sending drone */
+                double    start; /**< Time (s) the transfer starts */
+                uint64_t  bytes; /**< Bytes to transfer */
+                uint64_t  rx; /**< Bytes the sink got so far */
+                double    done; /**< Time (s) the last byte arrived, -1 while incomplete */
+            };
+
+            /**
+             * @brief What the sink got from one drone
+             */
+            struct DroneStats
+            {
+                uint64_t  bytes     = 0; /**< Bytes received */
+                uint64_t  segments  = 0; /**< Segments received */
+                double    first     = -1; /**< Start (s) of the first job */
+                double    last      = 0; /**< Time (s) of the last byte */
+                double    delay_sum = 0; /**< Sum of the queueing delays (s) */
+                double    delay_max = 0; /**< Largest queueing delay (s) */
+                size_t    cursor    = 0; /**< First job of the drone still incomplete, index into its jobs */
+                std::vector<size_t> jobs; /**< Jobs of the drone in start order, index into Offload::jobs */
+            };
+
+            /**
+             * @brief Construct a new Offload object with the default workload, one image of
+             * 536*20 bytes over TCP per round
+             */
+            Offload ();
+
+            /**
+             * @brief Replace the workload and transport, before installSink
+             *
+             * @param cfg configuration
+             */
+            void configure (const Config& cfg);
+
+            /**
+             * @brief Parse a payload model name: imagery, video or telemetry
+             *
+             * @param name name of the model
+             * @param payload parsed model
+             * @return false if the name is unknown
+             */
+            static bool parsePayload (const std::string& name, Payload* payload);
+
+            /**
+             * @brief Install the TCP and UDP sinks on the base node and hook their traces
+             *
+             * @param node base node
+             * @param start time the sinks start
+             * @param stop time the sinks stop
+             */
+            void installSink (ns3::Ptr<ns3::Node> node, ns3::Time start, ns3::Time stop);
+
+            /**
+             * @brief Start a round of jobs of a drone as configured
+             *
+             * @param drone index of the drone
+             * @param node node of the drone
+             * @param sink_ip IP of the base node
+             * @param start delay from now before the first job starts
+             */
+            void startJob (int drone, ns3::Ptr<ns3::Node> node, const std::string& sink_ip, ns3::Time start);
+
+            /**
+             * @brief Sink trace, accounts a received segment
+             */
+            void rxTrace (ns3::Ptr<const ns3::Packet> p, const ns3::Address& from, const ns3::Address& to,
+                          const ns3::SeqTsSizeHeader& header);
+
+            /**
+             * @brief The TCP sink, for extra traces
+             */
+            ns3::Ptr<ns3::PacketSink> tcpSink () const;
+
+            /**
+             * @brief The UDP sink, for extra traces
+             */
+            ns3::Ptr<ns3::PacketSink> udpSink () const;
+
+            /**
+             * @brief Write per drone and aggregate goodput, job completion and queueing delay as CSV:
+             * drone,bytes,goodput_bps,jobs,completed,mean_completion_s,mean_delay_s,max_delay_s.
+             * The aggregate row has drone "all"
+             *
+             * @param path output file
+             */
+            void report (const std::string& path) const;
+
+        private:
+            /**
+             * @brief Install the sender application of one job and account it
+             */
+            void installJob (int drone, ns3::Ptr<ns3::Node> node, const std::string& sink_ip, ns3::Time start, uint64_t bytes);
+
+            /**
+             * @brief Stats of a drone, grown on demand
+             */
+            DroneStats& statsOf (int drone);
+
+            Config                                   cfg; /**< Workload and transport */
+            ns3::Ptr<ns3::PacketSink>                tcp_sink; /**< Sink of the TCP flows */
+            ns3::Ptr<ns3::PacketSink>                udp_sink; /**< Sink of the UDP flows */
+            std::vector<Job>                         jobs; /**< Every job, in start order per drone */
+            std::vector<DroneStats>                  drones; /**< Received data by drone index */
+    };
+};
@@ -0,0 +1,144 @@
+/**
+ * @brief Buffered binary trace of the packets received by the sinks
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+
+/**
+ * @namespace rnl
+ */
+namespace rnl {
+
+    /**
+     * @brief One received packet, as written to the trace file
+     */
+    struct TraceRecord
+    {
+        int64_t   t_ns; /**< Simulation time of the reception (ns) */
+        uint32_t  node; /**< Index of the receiving node */
+        uint32_t  src; /**< IPv4 address of the sender, host order */
+        uint32_t  bytes; /**< Size of the packet */
+        uint32_t  pad; /**< Keeps the record 8 byte aligned, 0 */
+    };
+
+    /**
+     * @brief Records packet receptions into a fixed size in-memory ring that a background
+     * thread drains to one open file. \n
+     * The simulation thread only copies a TraceRecord into the ring; nothing on that path
+     * allocates, locks or touches the file. When the writer falls behind and the ring is
+     * full the record is dropped and counted. \n
+     * The file starts with a TraceFileHeader followed by the raw records, exportText turns
+     * it into text offline.
+     */
+    class PacketTrace
+    {
+        public:
+            /**
+             * @brief Header at the start of a trace file
+             */
+            struct TraceFileHeader
+            {
+                char      magic[4]; /**< "RNLT" */
+                uint32_t  version; /**< VERSION */
+                uint32_t  record_size; /**< sizeof (TraceRecord) */
+                uint32_t  pad; /**< 0 */
+            };
+
+            static constexpr uint32_t VERSION = 1; /**< Version of the file layout */
+
+            /**
+             * @brief Construct a new Packet Trace object, closed
+             *
+             * @param capacity records the ring holds, rounded up to a power of two
+             */
+            explicit PacketTrace (size_t capacity = 1 << 16);
+
+            /**
+             * @brief Flushes and closes
+             */
+            ~PacketTrace ();
+
+            PacketTrace (const PacketTrace&) = delete;
+            PacketTrace& operator= (const PacketTrace&) = delete;
+
+            /**
+             * @brief Create the file, write the header and start the writer thread
+             *
+             * @param path trace file
+             * @return false if the file cannot be created
+             */
+            bool open (const std::string& path);
+
+            /**
+             * @brief Drain what is left, stop the writer thread and close the file
+             */
+            void close ();
+
+            /**
+             * @brief Append a record, called from the simulation thread only
+             */
+            void record (const TraceRecord& rec);
+
+            /**
+             * @brief Trace sink for the Rx trace source of a PacketSink, bind the trace and
+             * the node index with ns3::MakeBoundCallback
+             */
+            static void rxTrace (PacketTrace* trace, uint32_t node, ns3::Ptr<const ns3::Packet> p, const ns3::Address& from);
+
+            /**
+             * @brief Records dropped because the ring was full
+             */
+            uint64_t dropped () const;
+
+            /**
+             * @brief Records written to the file
+             */
+            uint64_t written () const;
+
+            /**
+             * @brief Convert a trace file to text, one line per packet. Packets of each sender
+             * are numbered 1..wrap, a blank line separates two rounds of a sender
+             *
+             * @param in_path binary trace
+             * @param out_path text output
+             * @param wrap packets of one transfer, the old pkt_rec_time.txt used 20
+             * @return false if the input is not a trace file
+             */
+            static bool exportText (const std::string& in_path, const std::string& out_path, uint32_t wrap = 20);
+
+        private:
+            /**
+             * @brief Body of the writer thread
+             */
+            void drain ();
+
+            /**
+             * @brief Write the records in [tail, head) of the ring, returns the new tail
+             */
+            size_t flush (size_t tail, size_t head);
+
+            std::vector<TraceRecord>  ring; /**< Records, indexed modulo the capacity */
+            size_t                    mask; /**< Capacity - 1 */
+            std::atomic<size_t>       head; /**< Next slot the producer writes */
+            std::atomic<size_t>       tail; /**< Next slot the writer reads */
+            std::atomic<bool>         running; /**< Writer thread keeps going */
+            std::atomic<uint64_t>     n_dropped; /**< Records dropped */
+            uint64_t                  n_written; /**< Records written, writer thread */
+            std::FILE*                file; /**< Output, nullptr when closed */
+            std::thread               writer; /**< Writer thread */
+            std::mutex                wake_mtx; /**< Guards the wake up of the writer */
+            std::condition_variable   wake_cv; /**< Wakes the writer when the ring fills up or on close */
+    };
+};
@@ -5,10 +5,13 @@
  */
 #pragma once
 
+#include <cstdint>
 #include <iomanip>
 #include <sstream>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <eigen3/Eigen/Dense>
 #include <cmath>
 
@@ -19,21 +22,39 @@
 #include "ns3/log.h"
 #include "ns3/netanim-module.h"
 
+#include "msg_codec.h"
+
 /**
  * @namespace rnl
  */
 namespace rnl{
-    static std::string DELIM           = "\n"; /** Delimiter used for serializing message to stringstream @see rnl::USMsg::serialize() @see URMsg::serialize() */
     static std::string DELIM_NBTHOP    = "|"; /** Delimiter for seperating neighbours at same hop count @see Nbt::serialize*/
-    static std::string DELIM_NBTPOS    = ".";  /** Delimiter for specifiying neighbour's position @see Nbt::serialize*/
+    static std::string DELIM_NBTPOS    = ":";  /** Delimiter for specifiying neighbour's position, must not occur in a number @see Nbt::serialize*/
     static std::string DELIM_NBTID_POS = ","; /** Delimiter for specifiying neighbouring hops @see Nbt::serialize*/
     static std::string DELIM_NBTMHOP   = "~~"; /** Delimiter seperating neighbours based on hop count @see Nbt::serialize*/
-    static std::string DELIM_POS       = ":"; /** Delimiter seperating coordinate value of robot pose @see URMsg::parseUnicast*/
-    static std::string IP_BASE         = "10.1.1."; /** IP Base*/
+    static std::string IP_BASE         = "10.1."; /** IP Base, a /16 so swarms of more than 254 nodes fit @see nodeAddress*/
+    static std::string MCAST_BASE      = "225.1."; /** Base of the cluster multicast groups @see Planner::clusterGroup*/
     static int         BASEID          = 50; /** Base Station IP Address */
-    static double      STEP            = 0.3; /** Step Size for discretizing */
+    static double      STEP            = 0.3; /** Distance (m) the lookahead cursor moves ahead along a path @see Trajectory::advance*/
     static double      RC              = 4.0; /** RC Distance as specified in the paper. Ideal distance of seperation between two nodes */
-
+    static double      NBT_QUANT       = 0.01; /** Quantization step (m) of neighbour positions in the binary neighbour table @see Nbt::serialize*/
+    static double      NBT_TIMEOUT     = 5.0; /** Seconds a neighbour may stay silent before it is dropped from the neighbour table, at least 2 * RATE_MAX_SKIP frames @see Nbt::expire*/
+    static double      DIRTY_DIST      = 0.05; /** Movement (m) since the last evaluation that makes a drone dirty @see Planner::advanceDirty*/
+    static double      COMM_RANGE      = 80.0; /** Radio range (m) of the setup in Properties::setWifi: 20 dBm, log distance loss (n = 3), -77.5 dBm sensitivity */
+    static double      SLOT_GUARD      = 0.05; /** Guard time of a TDMA half slot, as a fraction of the slot @see SlotScheduler*/
+    static double      RESLOT_INTERVAL = 5.0; /** Seconds between two reslots of the TDMA schedule @see Planner::reslotTick*/
+    static int         RATE_MAX_SKIP   = 8; /** Largest number of frames between two messages of a settled drone @see RateController*/
+    static double      RATE_LONG_DIST  = 3.0; /** Path (m) left ahead above which a drone counts as manoeuvring @see DroneSoc::isManoeuvring*/
+    static double      RATE_BUSY_HI    = 0.5; /** Channel busy fraction above which settled drones back off further @see RateController*/
+    static int         CTRL_RTX_FRAMES = 1; /** TDMA frames without an ack before a control command is sent again, in the sender's next unicast sub-slot @see DroneSoc::retransmitControl*/
+    static int         CTRL_RTX_MAX    = 5; /** Retransmissions of a control command before it is given up */
+    static int         NBT_MAX_ID      = 1024; /** Neighbour ids must be below this, bounds the index of the neighbour table */
+    static double      SITE_TOL        = 0.6; /** Distance (m) from its formation slot within which a drone has reached it, for slots without a tuned tolerance @see Formation::tolerance*/
+    static double      SEP_MIN         = 1.0; /** Drones closer than this (m) are logged as collision candidates @see Planner::checkSeparation*/
+    static double      CIRCLE_TOL      = 0.05; /** Movement (m) of a parent that invalidates the cached path to its circle range @see CircleCache*/
+    static double      RECRUIT_HOLD    = 2.1; /** Seconds a centre holds at its site, and after a left arm anchors, before it recruits its first arm @see Planner::holdRecruit*/
+    static double      SCAN_HOLD       = 7.0; /** Seconds from the last cluster being complete to the start of the scans @see Planner::doLawnMoverScanning*/
+    static double      SWEEP_WIDTH     = 1.0; /** Distance (m) between two lanes of a coverage path, the swath of a scanner @see Coverage*/
 
     /**
      * @enum 
@@ -67,9 +88,29 @@ namespace rnl{
         CBTOP           = 16    // GO BEHIND OF PARENT
     };
 
+    static int         CTRL_RELIABLE   = CLTOP | CRTOP | CBTOP | CCHANGEPAR; /** Control commands delivered with acks and retransmission */
+
+    /**
+     * @brief Address of a node, IP_BASE followed by the 16 bit host number id + 257, so
+     * node 0 is 10.1.1.1 and node 255 is 10.1.2.0
+     *
+     * @param id index of the node
+     */
+    std::string nodeAddress (int id);
+
+    /**
+     * @brief Index of the node with an address, the inverse of nodeAddress
+     *
+     * @param ip IPv4 address, host order
+     */
+    int nodeIndex (uint32_t ip);
+
     /**
      * @struct Nbt
-     * @brief For parsing and serializing data of neighbouring nodes
+     * @brief For parsing and serializing data of neighbouring nodes. \n
+     * Entries of each hop are kept packed in insertion order, with an index from id to
+     * entry so inserting, refreshing, looking up and removing a neighbour are O(1).
+     * Every entry carries the time it was last heard, expire drops the silent ones
      */
     struct Nbt
     {
@@ -78,42 +119,105 @@ namespace rnl{
          */
         Nbt ();
 
-        std::vector<std::pair<int, ns3::Vector3D>> one_hop; /**< ID and Location of One Hop Neighbour */ 
-        std::vector<std::pair<int, ns3::Vector3D>> two_hop; /**< ID and Location of Two Hop Neighbour */
+        std::vector<std::pair<int, ns3::Vector3D>> one_hop; /**< ID and Location of One Hop Neighbour. Read only, use updateNb */ 
+        std::vector<std::pair<int, ns3::Vector3D>> two_hop; /**< ID and Location of Two Hop Neighbour. Read only, use updateTwoHopNb */
+        std::vector<double>                        one_hop_seen; /**< Time (s) each one hop neighbour was last heard, parallel to one_hop */
+        std::vector<double>                        two_hop_seen; /**< Time (s) each two hop neighbour was last heard, parallel to two_hop */
         
         /**
-         * @brief Parse one hop neighbours here
+         * @brief Insert or refresh a one hop neighbour. Ids outside [0, NBT_MAX_ID) are ignored
+         * 
+         * @param id index of the neighbour
+         * @param pos last known position of the neighbour
+         * @param now time (s) at which the neighbour was heard
+         */
+        void updateNb(int id, const ns3::Vector3D& pos, double now);
+
+        /**
+         * @brief Insert or refresh a two hop neighbour. Ids outside [0, NBT_MAX_ID) are ignored
+         * 
+         * @param id index of the neighbour
+         * @param pos last known position of the neighbour
+         * @param now time (s) at which the neighbour was heard
+         */
+        void updateTwoHopNb(int id, const ns3::Vector3D& pos, double now);
+
+        /**
+         * @brief Last known position of a one hop neighbour
+         * 
+         * @param id index of the neighbour
+         * @return nullptr if id is not a one hop neighbour
+         */
+        const ns3::Vector3D* findNb(int id) const;
+
+        /**
+         * @brief Last known position of a two hop neighbour
          * 
-         * @param msg contains encoded data of one hop neighbours 
+         * @param id index of the neighbour
+         * @return nullptr if id is not a two hop neighbour
+         */
+        const ns3::Vector3D* findTwoHopNb(int id) const;
+
+        /**
+         * @brief Drop every neighbour not heard since now - timeout
+         * 
+         * @param now current time (s)
+         * @param timeout time (s) a neighbour may stay silent
+         * @return number of neighbours dropped
+         */
+        size_t expire(double now, double timeout);
+
+        /**
+         * @brief Drop every neighbour
          */
-        void parseSingleNb(std::string msg); 
+        void clear();
 
         /**
-         * @brief Serializes one_hop and two_hop neighbours to string
+         * @brief Serializes one_hop and two_hop neighbours to string in rnl::WIRE_FORMAT. \n
+         * The binary form is compact: \n
+         * magic(u8) origin(3 x zigzag varint, cm) \n
+         * one_hop_cnt(varint) { id(varint) dpos(3 x zigzag varint, cm from origin) } ... \n
+         * two_hop_cnt(varint) { id(varint) dpos(3 x zigzag varint, cm from origin) } ... \n
+         * Positions are quantized to rnl::NBT_QUANT and stored relative to the sender, so
+         * a neighbour within a few metres costs 4-7 bytes. \n
+         * The text form lists id,x:y:z| for every one hop neighbour, then ~~, then the two
+         * hop neighbours alike, with absolute positions
          * 
          * @param dst destination pointer where these need to be written to
+         * @param origin position of the sender, neighbour positions are encoded relative to it
          */
-        void serialize(std::string* dst);
+        void serialize(std::string* dst, const ns3::Vector3D& origin = ns3::Vector3D ());
+
+        /**
+         * @brief Replace this table by the one encoded in src, in either form written by
+         * serialize, told apart by the first byte. Parsed entries are stamped as heard at time 0
+         * 
+         * @param src serialized neighbour table
+         * @return ParseStatus::OK on success, the reason of failure otherwise
+         */
+        ParseStatus parse(std::string_view src);
+
+    private:
+        /**
+         * @brief parse of the text form
+         */
+        ParseStatus parseText(std::string_view src);
+
+        std::vector<int>                           one_hop_idx; /**< Entry of each id in one_hop, -1 if absent */
+        std::vector<int>                           two_hop_idx; /**< Entry of each id in two_hop, -1 if absent */
     };
 
     /**
-    * @struct USMsg
+    * @struct UMsg
     * 
     * @brief
-    * This Structure will be Serialized and sent as Unicast Message. The \n
-    * communication will have this format. Each drone sends \n
-    * Unicast Message in this format. The serializer will make a \n
-    * delimiter seperated string which will be passed onto the sockets \n
-    * for transmission. \n
+    * Fields of the Unicast Message, shared by the sending (USMsg) and the \n
+    * receiving (URMsg) side. Each drone sends Unicast Message in this format. \n
+    * The wire layout is generated from Schema<UMsg>, in this order: \n
     * 
-    * * msg_type (char) - Is the message unicast/broadcast (u/b) \n
     * * source_id  (int)- The ID which I have while Sending the message \n
     * * dst_id (int)    - The Destination ID, Message will be sent to this ID \n
-    * * nbs    (string) - The Neighbour Table Of this Node, \n
-                          Format of String is seperated as follows: \n
-                          (.. | ID(int), hop(int), pos(ns3::Vector) | ..) \n 
-                          hop - 1,2,3 ...  \n
-                          pos - x (float) : y (float) : z (float) \n
+    * * nbs    (string) - The Neighbour Table Of this Node, @see Nbt::serialize \n
     * * control (int)   - This is a bit field which consists of all possible \n
                           control commands a particular drone can give. \n
                           1   -> Drone Should Hold Pos at RC from Parent \n
@@ -138,28 +242,28 @@ namespace rnl{
     * * p_id (int)      - Parent Id \n
     * * neigh_cnt (int) - Neighbour Count \n
     * * p_loc (ns3::Vector3D)  - Location of the Parent \n
-    * * bc_nbs (string)        - Broadcast Neighbours \n
+    * * ctrl_seq (int)  - Sequence number of the control command, the receiver \n
+                          acks it with an AckMsg. 0 when no ack is wanted \n
     */
-    struct USMsg
+    struct UMsg
     {
-        std::string       msg_type = "u"; /**< Message type. "u" for unicast, "b" for broadcast */
         int               source_id; /**< source index from which this message originated */
         int               dst_id; /**< Destination index to which this message was intended to be sent */
-        std::string       nbs; /**< Information about my neighbours */
+        std::string       nbs; /**< Serialized neighbour table of the source */
         int               control; /**< Control information to receiver */
         int               state; /**< State information of the sender */
-        int               p_id; /**< My Parent Index */
-        int               neigh_cnt;/**< My Neighbour Count */
-        ns3::Vector3D     p_loc; /**< My Parent Location */
-        std::string       bc_nbs; /**< Neighbours broadcasting to me */
-        
+        int               p_id; /**< Parent Index */
+        int               neigh_cnt;/**< Neighbour Count */
+        ns3::Vector3D     p_loc; /**< Parent Location */
+        int               ctrl_seq; /**< Sequence number of the control command to ack, 0 for none */
+
         /**
-         * @brief Construct a new USMsg object
+         * @brief Construct a new UMsg object with every field set to -998 (unknown), ctrl_seq to 0
          */
-        USMsg () ;
+        UMsg () ;
 
         /**
-         * @brief Construct a new USMsg object
+         * @brief Construct a new UMsg object
          * 
          * @param id source index
          * @param dst destination index
@@ -170,7 +274,7 @@ namespace rnl{
          * @param neigh_count my neighbour count
          * @param _ploc my parent location
          */
-        USMsg 
+        UMsg 
         (int                     id,
         int                      dst,
         const std::string&       nbs,
@@ -180,77 +284,110 @@ namespace rnl{
         int                      neigh_count,
         ns3::Vector3D            _ploc
         );
+    };
+
+    template <>
+    struct Schema<UMsg>
+    {
+        static constexpr char type   = 'u';
+        static constexpr auto fields = std::make_tuple (&UMsg::source_id, &UMsg::dst_id, &UMsg::nbs, &UMsg::control,
+                                                        &UMsg::state, &UMsg::p_id, &UMsg::neigh_cnt, &UMsg::p_loc,
+                                                        &UMsg::ctrl_seq);
+    };
+
+    /**
+    * @struct BcMsg
+    * 
+    * @brief Broadcast beacon, announces the position of a node to every node in range \n
+    * 
+    * * id (int)              - Index of the broadcasting node \n
+    * * pos (ns3::Vector3D)   - Position of the broadcasting node \n
+    */
+    struct BcMsg
+    {
+        int               id; /**< Index of the broadcasting node */
+        ns3::Vector3D     pos; /**< Position of the broadcasting node */
+    };
+
+    template <>
+    struct Schema<BcMsg>
+    {
+        static constexpr char type   = 'b';
+        static constexpr auto fields = std::make_tuple (&BcMsg::id, &BcMsg::pos);
+    };
+
+    /**
+    * @struct AckMsg
+    * 
+    * @brief Acknowledges a control command, sent back to the commanding node \n
+    * 
+    * * id (int)              - Index of the acknowledging node \n
+    * * seq (int)             - ctrl_seq of the acknowledged command \n
+    */
+    struct AckMsg
+    {
+        int               id; /**< Index of the acknowledging node */
+        int               seq; /**< ctrl_seq of the acknowledged command */
+    };
+
+    template <>
+    struct Schema<AckMsg>
+    {
+        static constexpr char type   = 'a';
+        static constexpr auto fields = std::make_tuple (&AckMsg::id, &AckMsg::seq);
+    };
+
+    /**
+    * @struct USMsg
+    * 
+    * @brief This Structure will be Serialized and sent as Unicast Message. \n
+    * The serializer will make a frame in rnl::WIRE_FORMAT which will be passed \n
+    * onto the sockets for transmission. @see UMsg for the fields \n
+    */
+    struct USMsg : UMsg
+    {
+        using UMsg::UMsg;
 
         /**
          * @brief Serialize the member attributes of this structure to a Unicast Message
+         * in rnl::WIRE_FORMAT
          * 
          * @param loc Pointer to string to which this needs to be serialized
          */
         void serialize (std::string * loc);
 
         /**
-         * @brief Serialize the member attributes of this structure to a broadcast message.
-         * No personal member info serialized
+         * @brief Serialize the member attributes of this structure to a broadcast message
+         * in rnl::WIRE_FORMAT. No personal member info serialized
          * 
          * @param loc Pointer to string to which this needs to be serialized
          * @param id index
          * @param pos Position 
          */
         void serializeBC (std::string * loc, int id, ns3::Vector3D pos);
+
+        /**
+         * @brief Serialize an ack of a control command in rnl::WIRE_FORMAT
+         * 
+         * @param loc Pointer to string to which this needs to be serialized
+         * @param id index of the acknowledging node
+         * @param seq ctrl_seq of the acknowledged command
+         */
+        void serializeAck (std::string * loc, int id, int seq);
     };
 
     /**
     * @struct URMsg
     * 
-    * @brief This Structure Will be parsed as a Unicast Message. The \n
-    * communication will have this format. Each drone receives \n
-    * Unicast Message in this format. The parser will convert \n
-    * the received message into struct members. \n
-    * 
-    * * source_id  (int)- The ID which I have while Sending the message \n
-    * * dst_id (int)    - The Destination ID, Message will be sent to this ID \n
-    * * nbs    (string) - The Neighbour Table of this Node, \n
-                          Format of String is seperated as follows: \n
-                          (.. | ID(int), hop(int), pos(ns3::Vector) | ..) \n 
-                          hop - 1,2,3 ... \n
-                          pos - x (float) : y (float) : z (float) \n
-    * * control (int)   - This is a bit field which consists of all possible \n
-                          control commands a particular drone can give. \n
-                          1   -> Drone Should Hold Pos at RC from Parent \n
-                          2   -> Drone Should Change Parent to p_id \n
-                          4   -> Drone Should Go Left of the p_id \n
-                          8   -> Drone Should Go Right of the p_id \n
-                          16  -> Drone Should Go Behind of the p_id \n
-                          
-    * * state (int)     - This is a bit field consisting of the state this \n
-                          drone is in. \n
-                          1   -> Site Reached \n
-                          2   -> On Straight Line \n
-                          4   -> Going Left/Right/Behind \n
-                          8   -> Left Neighbour \n
-                          16  -> Right Neighbour \n
-                          32  -> Centre Neighbour \n
-                          64  -> (Global) Site Reached \n
-                          128 -> (Global) Drone required \n
-                          256 -> Lawnmovering \n
-                          512 -> Changing Parent \n
-
-    * * p_id (int)      - Parent Id \n
-    * * neigh_cnt (int) - Neighbour Count \n
-    * * p_loc (ns3::Vector3D)  - Location of the Parent \n
-    * * bc_nbs (string)        - Broadcast Neighbours \n
+    * @brief This Structure Will be parsed as a Unicast Message, a broadcast \n
+    * beacon or an ack. The parser will convert the received message into struct members. \n
+    * @see UMsg for the fields \n
     */
-    struct URMsg
+    struct URMsg : UMsg
     {
-        int               source_id; /**< Source id from where the message originated */
-        int               dst_id; /**< Destination ID, the desired location the message was sent to */
-        std::string       nbs; /**< Neighbourhood of the source ID */
-        int               control; /**< Control Command from source id to destination id */
-        int               state; /**< State of the source */
-        int               p_id; /**< Parent ID to be followed by the dst_id */
-        int               neigh_cnt; /**< Neighbour Count */
-        ns3::Vector3D     p_loc; /**< Location of Parent */
-        std::string       bc_nbs; /**< Broadcast neighbours of Source ID, known if rnl::USMsg::msg_type is "u"*/
+        char              msg_type; /**< Type of the last parsed message. 'u' for unicast, 'b' for broadcast, 'a' for ack */
+        BcMsg             bc; /**< Last broadcast beacon, valid if msg_type is 'b' */
+        AckMsg            ack; /**< Last ack, valid if msg_type is 'a' */
 
         /**
          * @brief Construct a new URMsg object
@@ -281,25 +418,18 @@ namespace rnl{
         );
         
         /**
-         * @brief Parse an incoming Message 
-         * 
-         * @param msg Incoming message on the socket converted to string and passed here
-         */
-        void parse (std::string& msg);
-
-        /**
-         * @brief Parse an incoming Broadcast Message
-         * 
-         * @param msg If Incoming message is Broadcast parsed here 
-         */
-        void parseBroadcast (std::string& msg);
-
-        /**
-         * @brief Parse an incoming Unicast Message
+         * @brief Parse an incoming Message in a single pass, without copying or allocating
+         * beyond the capacity already held by nbs. Unicast fields are only updated when the
+         * whole frame is valid. Binary frames are recognised by rnl::WIRE_MAGIC,
+         * everything else is parsed as text
          * 
-         * @param msg If Incoming message is Unicast parsed here
+         * @param data Incoming message on the socket
+         * @param len Length of the message in bytes
+         * @return ParseStatus::OK on success, the reason of failure otherwise
          */
-        void parseUnicast   (std::string& msg);
+        ParseStatus parse (const uint8_t* data, size_t len);
 
+    private:
+        UMsg              staged; /**< Unicast frame being parsed, copied over the fields once valid */
     };
 };
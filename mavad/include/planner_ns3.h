@@ -5,8 +5,23 @@
 
 #include "planner_config.h"
 #include "planner_ns3_utils.h"
+#include "buffer_pool.h"
+#include "slot_scheduler.h"
+#include "rate_controller.h"
+#include "offload.h"
+#include "coverage.h"
+#include "packet_trace.h"
+#include "flow_stats.h"
+#include "formation.h"
+#include "swarm_state.h"
+#include "spatial_grid.h"
+#include "thread_pool.h"
+#include "drone_fsm.h"
 #include "ns3/core-module.h"
 #include <cmath>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
 
 #include <ros/ros.h>
 #include <geometry_msgs/PoseStamped.h>
@@ -17,6 +32,7 @@
 #include "ns3/string.h"
 #include "ns3/log.h"
 #include "ns3/yans-wifi-helper.h"
+#include "ns3/wifi-phy-state.h"
 #include "ns3/mobility-helper.h"
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/yans-wifi-channel.h"
@@ -26,22 +42,43 @@
 #include "ns3/netanim-module.h"
 
 #include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-l3-protocol.h"
 
 /**
- * @brief Trace to capture the pkt number, pkt receive time and sender node id
- * in pkt_rec_time.txt file
- *
- * @param index Receiver node id
- * @param p received pkt
- * @param a sender's ip address
+ * @namespace rnl
  */
-void TraceSink (std::size_t index, ns3::Ptr<const ns3::Packet> p, const ns3::Address& a);
+namespace rnl {
+    /**
+     * @struct CtrlSample
+     * @brief Delivery record of one reliable control command @see DroneSoc::trackControl
+     */
+    struct CtrlSample
+    {
+        int     seq; /**< ctrl_seq of the command */
+        int     control; /**< Control bits of the command */
+        double  sent; /**< Time (s) of the first transmission */
+        double  latency; /**< Time (s) from the first transmission to the ack, -1 if never acked */
+        int     retries; /**< Retransmissions */
+    };
+};
 
 /**
  * @namespace 
  */
 namespace rnl{
 
+    /**
+     * @brief Last path to the circle range of its parent a drone built, reused while the
+     * parent stays put @see Planner::runAction
+     */
+    struct CircleCache
+    {
+        bool          valid = false; /**< Cleared when a new parent location arrives */
+        ns3::Vector3D anchor; /**< Parent location the path was built for */
+        double        radius = 0; /**< Circling radius the path was built for */
+        uint64_t      path_gen = 0; /**< DroneSoc::path_gen right after the build, any later path invalidates it */
+    };
+
     /**
      * @brief Drone Socket common for planning and communication
      */
@@ -62,7 +99,10 @@ namespace rnl{
         void sendPacket (ns3::Time pktInterval, int n);
 
         /**
-         * @brief Sends a braoadcast packet.
+         * @brief Sends a braoadcast packet. \n
+         * On a TDMA schedule this is a loop of its own, once per frame in the broadcast half
+         * of the drone's slot while toggle_bc is on, so beacons do not back off with the
+         * unicasts. It stops when the drone leaves the schedule
          *
          * @param pktInterval Deprecated
          * @param n Deprecated
@@ -71,17 +111,46 @@ namespace rnl{
         
         /**
          * @brief Socket receiving callback. \n
-         * This function will be called as an interrupt if something is received at the socket end 
+         * This function will be called as an interrupt if something is received at the socket end. \n
+         * Every queued packet is copied into a pooled scratch buffer and handled in arrival order
          * 
          * @param soc Socket at which the message will be received 
          */
         void receivePacket (ns3::Ptr<ns3::Socket> soc);
 
+        /**
+         * @brief Parse one received frame and apply it to msg_rec and the neighbour table
+         * 
+         * @param data Bytes of the frame
+         * @param len Length of the frame in bytes
+         */
+        void handleFrame (const uint8_t* data, size_t len);
+
         /**
          * @brief Terminate all sockets and send shut down command for this node
          */
         void closeSender ();
         
+        /**
+         * @brief Whether the drone is anchoring, changing parent or following a long path,
+         * the messages of such a drone go out every frame @see RateController
+         */
+        bool isManoeuvring () const;
+
+        /**
+         * @brief Wifi phy state trace, feeds the channel busy time to the rate controller
+         * 
+         * @param start start of the state
+         * @param duration duration of the state
+         * @param state phy state
+         */
+        void phyStateCb (ns3::Time start, ns3::Time duration, ns3::WifiPhyState state);
+
+        /**
+         * @brief Queue this drone for re-evaluation by the event driven planner, once per tick
+         */
+        void markDirty ();
+
         /**
          * @brief update send message with the correct parent location to follow
          */
@@ -96,7 +165,9 @@ namespace rnl{
         void setBcSender (ns3::Ptr<ns3::Node> node, ns3::TypeId tid);
         
         /**
-         * @brief Initialize the sender for UDP msgs
+         * @brief Point the UDP sender at ip. \n
+         * Connected sockets are cached per destination, so retargeting to a destination
+         * used before is a lookup; a socket is only created the first time
          * 
          * @param node node 
          * @param tid type id
@@ -105,14 +176,58 @@ namespace rnl{
         void setSender (ns3::Ptr<ns3::Node> node, ns3::TypeId tid, const std::string& ip);
 
         /**
-         * @brief Initialize the sender for TCP msgs
+         * @brief Cached connected UDP socket to ip, created on first use. Does not retarget source
          * 
          * @param node node 
-         * @param self_ip IP of the sender socket
-         * @param remote_ip IP of the receiver/remote socket
-         * @param startTime Time when sender application will start sending
+         * @param tid type id
+         * @param ip IP of the receiver socket
+         * @return ns3::Ptr<ns3::Socket> the socket
          */
-        void setSenderTCP (ns3::Ptr<ns3::Node> node, const std::string& self_ip, const std::string& remote_ip, ns3::Time startTime);
+        ns3::Ptr<ns3::Socket> senderFor (ns3::Ptr<ns3::Node> node, ns3::TypeId tid, const std::string& ip);
+
+        /**
+         * @brief Give the control command of msg_send a sequence number if it needs an ack. \n
+         * A command is new when its bits (within CTRL_RELIABLE) or its destination socket change.
+         * msg_send.ctrl_seq carries the number until the ack comes back, and a retransmit
+         * timer runs meanwhile
+         */
+        void trackControl ();
+
+        /**
+         * @brief Retransmit timer of a control command. Sends msg_send again on the command's
+         * socket, up to CTRL_RTX_MAX times, unless it was acked or superseded. A regular
+         * unicast in the same sub-slot counts as the retransmission
+         * 
+         * @param seq ctrl_seq of the command
+         */
+        void retransmitControl (int seq);
+
+        /**
+         * @brief When a pending control command is due again: the first unicast sub-slot
+         * CTRL_RTX_FRAMES frames from now, or CTRL_RTX_FRAMES * frame_len without a schedule
+         */
+        ns3::Time retransmitTime () const;
+
+        /**
+         * @brief Close the pending control command and log its delivery
+         * 
+         * @param acked whether the ack came back
+         */
+        void finishControl (bool acked);
+
+        /**
+         * @brief Queue an AckMsg for a control command back to its sender. The queue goes out
+         * in this drone's next unicast sub-slot, at once without a schedule @see flushAcks
+         * 
+         * @param to index of the commanding drone
+         * @param seq ctrl_seq of the command
+         */
+        void sendAck (int to, int seq);
+
+        /**
+         * @brief Send the queued acks, one AckMsg per command
+         */
+        void flushAcks ();
 
         /**
          * @brief Initialize the receiver for UDP msgs
@@ -123,30 +238,76 @@ namespace rnl{
         void setRecv   (ns3::Ptr<ns3::Node> node, ns3::TypeId tid);
 
         /**
-         * @brief Initialize the receiver for TCP msgs
-         * 
-         * @param node node 
-         * @param ip IP of the receiver
-         * @param num_nodes Number of nodes
-         * @param stopTime Time when receiver application can stop
+         * @brief Current position of the drone @see SwarmState
+         */
+        ns3::Vector3D pos () const;
+
+        /**
+         * @brief Set the current position of the drone
+         */
+        void setPos (const ns3::Vector3D& p);
+
+        /**
+         * @brief Arc length of the look ahead cursor along traj
+         */
+        double lookAheadDist () const;
+
+        /**
+         * @brief Move the look ahead cursor along traj
+         *
+         * @param s arc length from the start of traj
+         */
+        void setLookAhead (double s);
+
+        /**
+         * @brief Put the look ahead cursor one STEP into traj, after every change of traj
+         */
+        void startPath ();
+
+        /**
+         * @brief Mirror the state, control and parent of msg_send into the store, called
+         * at the end of every FSM pass that may change them
          */
-        void setRecvTCP (ns3::Ptr<ns3::Node> node, const std::string& ip, int num_nodes, ns3::Time stopTime);
+        void syncState ();
         
-        ns3::Ptr<ns3::Socket>         source; /**< Socket for sending unicast messages */
+        ns3::Ptr<ns3::Socket>         source; /**< Socket for sending unicast messages, the cached socket of the current destination */
+        std::unordered_map<uint32_t, ns3::Ptr<ns3::Socket>> sender_cache; /**< Connected unicast sockets keyed by destination address @see setSender */
         ns3::Ptr<ns3::Socket>         source_bc; /**< Socket for sending broadcast messages */
 
         ns3::Ptr<ns3::Socket>         recv_sink; /**< Receiver/sink socket */
         int                           id; /**< Id of this drone soc */
-        int                           anch_id; /**< Anchoring Id if any */
-        int                           circle_dir; /**Circling direction */
-        ns3::Vector3D                 anch_pos; /**< Anchoring position */
         rnl::USMsg                    msg_send; /**< message to send */
         rnl::URMsg                    msg_rec; /**< Message received */
         rnl::Nbt                      nbt; /**< Neighbour table */
-        std::vector<ns3::Vector3D>    wpts; /**< Waypoints that drone needs to follow */
-        ns3::Vector3D                 pos; /**< Current position of the drone */
-        int                           lookaheadindex; /**< Look ahead index for the drone */
+        rnl::Nbt                      peer_nbt; /**< Scratch table the sender's neighbour table is decoded into */
+        rnl::Trajectory               traj; /**< Path that drone needs to follow */
+        uint64_t                      path_gen; /**< Paths started so far @see startPath */
+        uint64_t                      scan_gen; /**< path_gen of its coverage path @see Planner::replayCoverage */
+        rnl::CircleCache              circle_cache; /**< Path to RC from the parent, kept while the parent stays put */
+        rnl::SwarmState*              hot; /**< Store of the position, lookahead, message bits and anchor of every drone, owned by the planner */
         int                           toggle_bc; /**< toggle broadcast on/off */
+        rnl::BufferPool               tx_pool; /**< Serialization buffers of the send paths, reused across packets */
+        rnl::BufferPool               rx_pool; /**< Scratch buffers of the receive path, reused across packets */
+        bool                          dirty; /**< Queued for re-evaluation @see Planner::advanceDirty */
+        std::vector<int>*             dirty_queue; /**< Queue of the planner markDirty appends to, nullptr until the simulation starts */
+        ns3::Vector3D                 eval_pos; /**< Position at the last evaluation, moving DIRTY_DIST away from it marks the drone dirty */
+        const rnl::SlotScheduler*     slots; /**< TDMA schedule of the swarm, nullptr sends every n * pktInterval */
+        rnl::RateController           rate; /**< Frames between two unicasts of this drone */
+        int                           last_state; /**< State sent in the previous unicast */
+        int                           last_control; /**< Control sent in the previous unicast */
+        ns3::TypeId                   udp_tid; /**< Type id of the unicast sockets */
+        int                           ctrl_counter; /**< Last ctrl_seq handed out */
+        int                           ctrl_cmd; /**< Control bits of the pending command, 0 if none */
+        ns3::Ptr<ns3::Socket>         ctrl_soc; /**< Socket the pending command goes out on */
+        bool                          ctrl_active; /**< The pending command waits for its ack */
+        rnl::CtrlSample               ctrl_pending; /**< Delivery record of the pending command */
+        std::vector<rnl::CtrlSample>  ctrl_log; /**< Delivery records of the finished commands */
+        ns3::Time                     frame_len; /**< Frame length at the last unicast, n * pktInterval without a schedule */
+        ns3::Time                     last_send; /**< When the last regular unicast went out */
+        ns3::Time                     next_send; /**< When the next regular unicast is due */
+        std::vector<std::pair<int, int>> ack_queue; /**< Acks waiting for the next sub-slot, as (to, seq) */
+        bool                          sending; /**< The unicast loop is running @see sendPacket */
+        bool                          beaconing; /**< The beacon loop is running @see sendBcPacket */
 
         ros::Publisher                drone_lk_ahead_pub;
         ros::Subscriber               drone_pos_sub;
@@ -171,6 +332,31 @@ namespace rnl{
         void posSubCb (const geometry_msgs::PoseStamped& _pos);
     };
 
+    /**
+     * @brief Side effects of planning one drone on shared state: the retargets of its
+     * sender, its log lines, the reset of the recruit counter and the transitions it took.
+     * Buffered while the drones are planned in parallel and committed in ID order
+     * @see Planner::updateWpts
+     */
+    struct PlanEffects
+    {
+        /**
+         * @brief A transition taken and the run time of its action
+         */
+        struct Fired
+        {
+            rnl::FsmPhase phase;
+            rnl::FsmEvent event;
+            double        seconds;
+        };
+
+        std::vector<std::pair<ns3::Time, std::string>> retarget; /**< Delay and destination of each setSender */
+        std::ostringstream                             log; /**< Lines for std::cerr */
+        bool                                           hold_recruit = false; /**< Restart the hold before a centre recruits its first arm @see Planner::holdRecruit */
+        bool                                           start_scans = false; /**< The last cluster is complete, start the scans if not yet scheduled */
+        std::vector<Fired>                             fired; /**< Transitions taken, for FsmStats */
+    };
+
     /**
      * @class 
      * @brief Wifi properties set in this class and passed to planner
@@ -227,6 +413,30 @@ namespace rnl{
              */
             void SetStaticRoute(ns3::Ptr<ns3::Node> n, const char* destination, const char* nextHop, uint32_t interface);
 
+            /**
+             * @brief Static routes between every drone and the base node along the relay
+             * tree of a formation @see Formation::towardBase
+             *
+             * @param f formation of the swarm
+             */
+            void setRoutes(const rnl::Formation& f);
+
+            /**
+             * @brief Send packets to multicast groups out of interface
+             *
+             * @param n            node
+             * @param interface    Interface
+             */
+            void SetMulticastRoute(ns3::Ptr<ns3::Node> n, uint32_t interface);
+
+            /**
+             * @brief Make a node deliver the packets of a multicast group to its sockets
+             *
+             * @param n            node
+             * @param group        IP address of the group
+             */
+            void JoinGroup(ns3::Ptr<ns3::Node> n, const std::string& group);
+
             ns3::NodeContainer c; /**< Node container containing all the nodes */
             
             /**
@@ -333,24 +543,60 @@ namespace rnl{
             void setLeaderExplorePath ();
             
             /**
-             * @brief   Check if the drone reached the site or not
+             * @brief   Check if the drone reached its formation slot or not
              *
              * @param   node_pos  Current node position
              * @param   ID        ID of the drone
              *
-             * @return  true if drone reached else false
+             * @return  true if drone reached else false, always false for drones without a slot
              */
-            static bool siteReached (ns3::Vector3D node_pos, int ID);
+            bool siteReached (ns3::Vector3D node_pos, int ID) const;
 
             /**
              * @brief Start simulation
              */
             void startSimul ();
 
+            /**
+             * @brief Print the buffer pool counters of every drone. Heap allocations should
+             * stop growing once the pools are warm, whatever the run length
+             */
+            void reportPoolStats ();
+
+            /**
+             * @brief Print how many unicasts every drone sent against the frames that passed
+             */
+            void reportRateStats ();
+
+            /**
+             * @brief Write the delivery record of every control command as CSV:
+             * drone,seq,control,sent,latency,retries. latency is -1 for commands never acked
+             *
+             * @param path output file
+             */
+            void exportCtrlLatency (const std::string& path);
+
             /**
              * @brief Increment look ahead point. (Assuming no dynamics), spawning nodes at distances
              */
             void incLookAhead ();
+
+            /**
+             * @brief Increment look ahead point of one drone
+             *
+             * @param i ID of the drone
+             */
+            void incLookAhead (int i);
+
+            /**
+             * @brief Update the state of one CENTRE drone, @see updateStateofCentre. \n
+             * Once at its slot the centre raises CENTRE_ARRIVED the first time, counts the
+             * child being recruited once it reaches its slot, then raises one cluster event
+             * (KID_PENDING, CLUSTER_COMPLETE, RELAY or RELAY_REQUEST) @see FSM_TRANSITIONS
+             *
+             * @param i ID of the centre drone
+             */
+            void updateCentre (int i);
             
             /**
              * @brief      Update the state of CENTRE drones and sends control commands to their neighbours
@@ -358,7 +604,7 @@ namespace rnl{
             void updateStateofCentre ();
 
             /**
-             * @brief Update the position of UAVs after one time step
+             * @brief Update the position of UAVs after one time step, in ns-3 and in the spatial grid
              */
             void updatePosSocs();
 
@@ -372,32 +618,227 @@ namespace rnl{
              */
             void updateWpts(int id);
 
+            /**
+             * @brief updateWpts for several drones: planned across the thread pool, committed
+             * in the order of ids, with the same result as calling updateWpts on each in turn
+             * @see setPlanThreads
+             *
+             * @param ids IDs of the drones, in commit order
+             */
+            void updateWpts (const std::vector<int>& ids);
+
+            /**
+             * @brief Decision and trajectory part of updateWpts: dispatches the control
+             * commands of msg_rec in FSM_COMMANDS order. Reads the messages of the drone and
+             * writes only its DroneSoc and store entries, so drones can be planned concurrently
+             *
+             * @param id index of UAV
+             * @param fx buffered side effects on shared state
+             */
+            void planWpts (int id, rnl::PlanEffects* fx);
+
+            /**
+             * @brief Look up the transition of an event in the current phase of a drone and
+             * run its action, if the phase does not ignore the event @see FSM_TRANSITIONS
+             *
+             * @param id index of UAV
+             * @param event event of the drone
+             * @param fx buffered side effects, the transition is recorded here
+             */
+            void dispatch (int id, rnl::FsmEvent event, rnl::PlanEffects* fx);
+
+            /**
+             * @brief Body of a transition
+             *
+             * @param action action of the transition
+             * @param id index of UAV
+             * @param fx buffered side effects on shared state
+             */
+            void runAction (rnl::FsmAction action, int id, rnl::PlanEffects* fx);
+
+            /**
+             * @brief Apply and clear the buffered side effects of planWpts or updateSoc, on the
+             * simulation thread
+             *
+             * @param id index of UAV
+             * @param fx side effects of the drone
+             */
+            void commitWpts (int id, rnl::PlanEffects* fx);
+
             /**
              * @brief Just calls updateWaypoints for every node in the swarm
              */
             void updateSocsfromRec ();
 
             /**
-             * @brief  Start lawn mover scanning.
+             * @brief  Start lawn mover scanning of a cluster: split its scan area across its
+             * arms, send each arm on its coverage path and start the offload of the arms and
+             * the centre. Once per assignment, a cluster already scanning is left alone
              *
-             * @param  interval  The interval after which the cycle of lawn
-             *                   mover scanning is repeated
-             * @param  id        ID of the drone
-             * @param  pos0      Initial position of the drone
+             * @param  centre    ID of the centre of the cluster
              */
-            void doLawnMoverScanning(ns3::Time interval, int id, ns3::Vector3D pos0);
+            void doLawnMoverScanning(int centre);
+
+            /**
+             * @brief Send a scanning drone that has flown its coverage cycle round it again
+             * and count the cycle @see Coverage
+             *
+             * @param i ID of the drone
+             */
+            void replayCoverage (int i);
 
             /**
              * @brief      Update the state of UAVs (Currently only LEFT and RIGHT drones)
              */
             void updateSocs  ();
 
+            /**
+             * @brief Update the state of one UAV, @see updateSocs
+             *
+             * @param i ID of the drone
+             */
+            void updateSoc (int i);
+
             /**
              * @brief Advance the position, runs repeatedly after interval time
              * 
              * @param interval time after which this function to repeat. Will determine the speed of simulation
              */
             void advancePos (ns3::Time interval);
+
+            /**
+             * @brief Event driven step of advancePos. Only drones marked dirty since the last tick
+             * (packet received, moved more than DIRTY_DIST, timer fired) and the centres of their
+             * clusters are re-evaluated. Drones still following a path stay dirty, hovering
+             * drones cost nothing until the next event
+             */
+            void advanceDirty ();
+
+            /**
+             * @brief Multicast group of the cluster of a centre drone
+             *
+             * @param centre ID of the centre drone
+             * @return std::string IP address of the group
+             */
+            static std::string clusterGroup (int centre);
+
+            /**
+             * @brief Join the drones a centre talks to (its children and the neighbouring
+             * centres, the tail for the last centre) to the centre's cluster group, so one
+             * transmission reaches all of them
+             */
+            void joinClusterGroups ();
+
+            /**
+             * @brief Recompute the TDMA slots from the current positions
+             */
+            void reslot ();
+
+            /**
+             * @brief Reslot periodically so spatial slot reuse follows the swarm
+             *
+             * @param interval time between reslots
+             */
+            void reslotTick (ns3::Time interval);
+
+            /**
+             * @brief Log every pair of drones closer than SEP_MIN, the collision candidates
+             *
+             * @return number of pairs
+             */
+            int checkSeparation ();
+
+            /**
+             * @brief Positions of the drones as of the last tick, for range and nearest
+             * neighbour queries @see SpatialGrid
+             */
+            const rnl::SpatialGrid& spatialGrid () const;
+
+            /**
+             * @brief Give a drone joining the swarm a slot, and restart its unicast and beacon
+             * loops in the new slot if they stopped when it left
+             *
+             * @param id ID of the drone
+             */
+            void joinDrone (int id);
+
+            /**
+             * @brief Free the slot of a drone leaving the swarm, it stops sending at its next slot
+             *
+             * @param id ID of the drone
+             */
+            void leaveDrone (int id);
+
+            /**
+             * @brief Timer target, marks a drone dirty
+             *
+             * @param id ID of the drone
+             */
+            void wake (int id);
+
+            /**
+             * @brief Centres recruit their first arm no earlier than RECRUIT_HOLD from now, and
+             * are woken then. Called when a centre reaches its site and when a left arm anchors
+             */
+            void holdRecruit ();
+
+            /**
+             * @brief Choose between polling every drone each tick (default) and the event driven step
+             *
+             * @param on true for event driven
+             */
+            void setEventDriven (bool on);
+
+            /**
+             * @brief Set the data offload workload, before startSimul
+             *
+             * @param cfg payload model and transport @see rnl::Offload
+             */
+            void setOffload (const rnl::Offload::Config& cfg);
+
+            /**
+             * @brief Set the formation of the swarm, before initializeSockets. Defaults to
+             * the T formation for the number of nodes
+             *
+             * @param f formation slot table
+             */
+            void setFormation (const rnl::Formation& f);
+
+            /**
+             * @brief Install FlowMonitor on all nodes in startSimul and write the per flow
+             * statistics to flows.csv, flows_snapshots.csv and flows.json after the run. Off by default
+             *
+             * @param interval time between two snapshots of the flow counters
+             */
+            void setFlowStats (ns3::Time interval);
+
+            /**
+             * @brief Threads planning the drones of a tick @see updateWpts. One by default,
+             * which plans inline on the simulation thread
+             *
+             * @param threads threads, the simulation thread included; 0 takes the hardware concurrency
+             */
+            void setPlanThreads (int threads);
+
+            /**
+             * @brief Take a drone off the TDMA schedule for a while: startSimul schedules
+             * leaveDrone at at and joinDrone at + duration later. Off by default
+             *
+             * @param id ID of the drone, -1 for none
+             * @param at simulation time of the leave
+             * @param duration time until it joins again
+             */
+            void setDropout (int id, ns3::Time at, ns3::Time duration);
+
+            /**
+             * @brief Area each cluster scans, split across its arms, and the distance between
+             * two lanes. By default every arm scans its own box, RC/3.2 in x and RC/2 in y around
+             * its slot, SWEEP_WIDTH apart, which keeps clear of the centre
+             *
+             * @param area vertices of the polygon relative to the slot of the centre, empty for the default
+             * @param width distance (m) between two lanes
+             */
+            void setCoverage (const rnl::Coverage::Polygon& area, double width);
             void takeOff (double _t);
             bool withinThreshold (const rnl::DroneSoc* _soc);
             
@@ -408,6 +849,14 @@ namespace rnl{
             ros::NodeHandle nh_private;
             rnl::Properties            wifi_prop; /**< wifi properties object */
             std::vector<rnl::DroneSoc> nsocs; /**< UAV Drone socs in the simulation, Each DroneSoc represents a UAV */
+            rnl::SwarmState            hot; /**< Hot per-drone state the per-tick passes stream over, indexed like nsocs */
+            std::vector<uint8_t>       la_hit; /**< Scratch, drones whose lookahead moves on this tick */
+            rnl::SpatialGrid           grid; /**< Drones bucketed by position, cells of RC */
+            std::vector<std::pair<int, int>> close_pairs; /**< Scratch, pairs found by checkSeparation */
+            rnl::ThreadPool            pool; /**< Workers of the planning phase @see setPlanThreads */
+            std::vector<rnl::PlanEffects> plan_fx; /**< Buffered side effects of each drone, by ID */
+            std::vector<int>           plan_ids; /**< Scratch, drones planned this tick */
+            rnl::FsmStats              fsm_stats; /**< Transitions taken by the drones, written to fsm.csv */
             int                        num_nodes; /**< number of nodes */
 
             ns3::MobilityHelper        mobility; /**< Mobility helper to set the initial mobility of the nodes */
@@ -417,6 +866,22 @@ namespace rnl{
             int                        leader_id; /**< Leader index */
             int                        ldirec_flag; /**< Deprecated */
             int                        lchild_id; /**< Child index */
-            int                        tail_id; /**< Child index */
+            rnl::Formation             formation; /**< Slot of every drone, cluster membership and recruit order */
+            bool                       event_driven; /**< Re-evaluate only dirty drones @see advanceDirty */
+            ns3::Time                  recruit_at; /**< Centres recruit their first arm from then on @see holdRecruit */
+            bool                       scan_scheduled; /**< The clusters' scans are scheduled, once the last cluster is complete */
+            std::vector<int>           dirty_ids; /**< Drones marked dirty since the last tick */
+            std::vector<int>           eval_ids; /**< Drones evaluated in the current tick */
+            rnl::SlotScheduler         slots; /**< TDMA schedule of the unicast and broadcast messages */
+            std::vector<ns3::Vector3D> slot_pos; /**< Scratch, positions handed to the scheduler */
+            rnl::Offload               offload; /**< Data offload of the scanners to the base node */
+            rnl::Coverage              coverage; /**< Coverage paths of the scanners, written to coverage.csv */
+            rnl::Coverage::Polygon     scan_area; /**< Scan area of a cluster relative to its centre slot, empty for the default @see setCoverage */
+            rnl::PacketTrace           trace; /**< Receptions at the offload sinks, pkt_rec_time.bin */
+            rnl::FlowStats             flows; /**< Per flow statistics @see setFlowStats */
+            ns3::Time                  flow_interval; /**< Snapshot interval of flows, zero when off */
+            int                        drop_id; /**< Drone that leaves the schedule for a while, -1 for none @see setDropout */
+            ns3::Time                  drop_at; /**< When it leaves */
+            ns3::Time                  drop_for; /**< How long it stays away */
     };
 };
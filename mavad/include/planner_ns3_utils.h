@@ -4,6 +4,7 @@
 #pragma once
 
 #include <iomanip>
+#include <iostream>
 #include <sstream>
 #include <vector>
 #include <string>
@@ -19,6 +20,8 @@
 #include "ns3/log.h"
 #include "ns3/netanim-module.h"
 
+#include "trajectory.h"
+
 /**
  * @namespace
  */
@@ -36,49 +39,59 @@ namespace rnl {
     );
 
     /**
-     * @brief Get a Trajectory for UAV
+     * @brief Get a Trajectory for UAV, a straight line
      * 
-     * @param wpts Waypoints pointer to be filled by final trajectory locations
+     * @param traj Trajectory to be replaced by the line
      * @param start_pos Starting position for the robot
      * @param end_pos Ending position for the robot
-     * @param step step size at which point seperation is required in the trajectory
+     * @param err where a failure is reported, a planning thread passes its PlanEffects::log
      * 
      * @return true if trajectory found else false
      */
     bool getTrajectory
     (
-        std::vector<ns3::Vector3D>* wpts,
-        ns3::Vector3D start_pos, 
-        ns3::Vector3D end_pos,
-        double        step 
+        rnl::Trajectory* traj,
+        ns3::Vector3D    start_pos, 
+        ns3::Vector3D    end_pos,
+        std::ostream*    err = &std::cerr
     );
 
+    /**
+     * @brief Append a straight line to a Trajectory
+     * 
+     * @param traj Trajectory to extend
+     * @param start_pos Start of the line, joined to the end of traj if apart
+     * @param end_pos End of the line
+     * @param err where a failure is reported, a planning thread passes its PlanEffects::log
+     * 
+     * @return true if the line was added else false
+     */
     bool getTrajectoryContinue
     (
-        std::vector<ns3::Vector3D>* wpts,
-        ns3::Vector3D start_pos, 
-        ns3::Vector3D end_pos,
-        double        step 
+        rnl::Trajectory* traj,
+        ns3::Vector3D    start_pos, 
+        ns3::Vector3D    end_pos,
+        std::ostream*    err = &std::cerr
     );
 
     /**
      * @brief Get the To Circle Range object
      * 
-     * @param wpts Waypoints pointer to be filled by final trajectory locations
+     * @param traj Trajectory to be replaced by the path to the circle
      * @param _anch_p Anchor position
      * @param _my_p Start Position
      * @param cr Circling Radius required
-     * @param step Step size at which to add waypoints
+     * @param err where a failure is reported, a planning thread passes its PlanEffects::log
      * 
      * @return true if succeeded else false
      */
     bool getToCircleRange
     (
-        std::vector<ns3::Vector3D>* wpts,
+        rnl::Trajectory*           traj,
         ns3::Vector3D              _anch_p,
         ns3::Vector3D              _my_p,
         float                      cr,
-        float                      step
+        std::ostream*              err = &std::cerr
     );
 
     /**
@@ -98,14 +111,14 @@ namespace rnl {
     );
 
     /**
-     * @brief Waypoints passed for Position Hold requirement
+     * @brief Trajectory for Position Hold requirement
      * 
-     * @param wpts Waypoints pointer to be filled by final trajectory locations
+     * @param traj Trajectory to be replaced by the single point
      * @param pos Position at which to hold position
      */
     void posHold
     (
-        std::vector<ns3::Vector3D>* wpts,
+        rnl::Trajectory*    traj,
         ns3::Vector3D       pos
     );
 };
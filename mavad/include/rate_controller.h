@@ -0,0 +1,81 @@
+/**
+ * @brief Adaptive message rate of a drone
+ */
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @namespace rnl
+ */
+namespace rnl {
+
+    /**
+     * @brief Decides how many TDMA frames a drone lets pass between two transmissions. \n
+     * A manoeuvring drone, or one whose state or control just changed, sends every frame.
+     * A settled drone (hovering, lawnmowering) doubles the gap after every send, up to
+     * max_skip frames, and up to twice that while the measured channel busy time is
+     * above busy_hi. The airtime saved goes to the bulk uploads of the scanners.
+     */
+    class RateController
+    {
+        public:
+            /**
+             * @brief Counters of the controller
+             */
+            struct Stats
+            {
+                uint64_t sends  = 0; /**< Transmissions */
+                uint64_t frames = 0; /**< Frames elapsed, a fixed rate sender would have sent in each */
+            };
+
+            /**
+             * @brief Construct a new Rate Controller object
+             *
+             * @param max_skip Largest gap (frames) of a settled drone on a quiet channel
+             * @param busy_hi Channel busy fraction above which settled drones back off further
+             */
+            RateController (int max_skip, double busy_hi);
+
+            /**
+             * @brief Account for a transmission and choose the gap to the next one
+             *
+             * @param manoeuvring the drone is anchoring, changing parent or following a long path
+             * @param changed the state or control sent differs from the previous transmission
+             * @param now current time (s), closes the busy time measurement window
+             * @return int frames until the next transmission, 1 is every frame
+             */
+            int next (bool manoeuvring, bool changed, double now);
+
+            /**
+             * @brief Add channel busy time (rx, tx or cca busy) seen by the drone
+             *
+             * @param seconds busy time
+             */
+            void addBusy (double seconds);
+
+            /**
+             * @brief Busy fraction measured over the last window
+             */
+            double busyFraction () const;
+
+            /**
+             * @brief Current gap in frames
+             */
+            int skip () const;
+
+            /**
+             * @brief Counters of the controller
+             */
+            const Stats& stats () const;
+
+        private:
+            int     k; /**< Current gap in frames */
+            int     max_skip; /**< Largest gap on a quiet channel */
+            double  busy_hi; /**< Busy fraction above which the gap may double again */
+            double  busy; /**< Busy time (s) accumulated in the current window */
+            double  window_start; /**< Start (s) of the current window */
+            double  busy_frac; /**< Busy fraction of the last closed window */
+            Stats   st; /**< Counters */
+    };
+};
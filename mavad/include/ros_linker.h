@@ -4,6 +4,7 @@
 #include <vector>
 #include <string>
 #include <ros/ros.h>
+#include <ros/serialization.h>
 #include <planner_msgs/DroneMsg.h>
 
 #include "ns3/core-module.h"
@@ -118,11 +119,13 @@ namespace rnl {
             void localStateCb2 (const planner_msgs::DroneMsg& drone_data);
             void localStateCb3 (const planner_msgs::DroneMsg& drone_data);
 
-            /*For converting rosmsg planner_msgs::DroneMsg to string for sending over the socket*/
-            std::string getTransmitMsg (const planner_msgs::DroneMsg& tr_msg);
+            /*For serializing rosmsg planner_msgs::DroneMsg with ros::serialization into the byte buffer sent over the socket.
+              The buffer keeps its capacity, so refreshing it allocates nothing after the first message*/
+            void getTransmitMsg (const planner_msgs::DroneMsg& tr_msg, std::vector<uint8_t>* dst);
             
-            /*For converting the received Message over ns3 to rosmsg DroneMsg for publishing it on the topic*/
-            planner_msgs::DroneMsg parseRecMsg (std::string& rc_msg);
+            /*For deserializing the received bytes over ns3 to rosmsg DroneMsg for publishing it on the topic.
+              Returns false and leaves rc_msg untouched if the payload is not a whole DroneMsg*/
+            bool parseRecMsg (const uint8_t* data, size_t len, planner_msgs::DroneMsg* rc_msg);
             /*********************************************************/
 
             // For using the mobility capbilities of NS3
@@ -141,9 +144,11 @@ namespace rnl {
             ros::Subscriber drone_state_sub2;
             ros::Subscriber drone_state_sub3;
 
-            std::ostringstream msg1;
-            std::ostringstream msg2;
-            std::ostringstream msg3;
+            std::vector<uint8_t> msg1; // Serialized DroneMsg of node n as msgn
+            std::vector<uint8_t> msg2;
+            std::vector<uint8_t> msg3;
+
+            std::vector<uint8_t> rx_buf; // Scratch buffer the received packets are copied into
 
             std::string phy_mode; 
             double rss;  // -dBm [Deprecated]
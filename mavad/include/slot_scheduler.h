@@ -0,0 +1,125 @@
+/**
+ * @brief TDMA slot scheduler for the unicast and broadcast messages of the swarm
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+#include "spatial_grid.h"
+
+/**
+ * @namespace rnl
+ */
+namespace rnl {
+
+    /**
+     * @brief Assigns every member drone a transmission slot of a repeating frame. \n
+     * A slot is split in two halves, the unicast message goes out at the start of the
+     * first half and the broadcast beacon at the start of the second. Each half starts
+     * with a guard time so the previous transmission has cleared the channel. \n
+     * Two drones closer than the reuse distance (two hops, ie twice the radio range)
+     * never share a slot; drones further apart may, so the frame length follows the
+     * density of the swarm rather than its size. Slots are assigned greedily in ID
+     * order and a drone keeps its slot across reslots whenever it stays conflict free. \n
+     * The conflicts of each drone come from one range query on a spatial grid with cells
+     * of the reuse distance, so a reslot is linear in the swarm unless it is all in range. \n
+     * Frames are aligned to time 0.
+     */
+    class SlotScheduler
+    {
+        public:
+            /**
+             * @brief Construct a new Slot Scheduler object
+             *
+             * @param slot_len Length of one slot (unicast + broadcast half)
+             * @param guard Guard time at the start of each half slot
+             * @param reuse_dist Drones closer than this (m) never share a slot
+             */
+            SlotScheduler (ns3::Time slot_len, ns3::Time guard, double reuse_dist);
+
+            /**
+             * @brief Add a drone, it gets a slot at the next reslot
+             *
+             * @param id ID of the drone
+             */
+            void join (int id);
+
+            /**
+             * @brief Remove a drone, its slot is free for others at the next reslot
+             *
+             * @param id ID of the drone
+             */
+            void leave (int id);
+
+            /**
+             * @brief Whether a drone is a member with a slot
+             */
+            bool isMember (int id) const;
+
+            /**
+             * @brief Whether members joined or left since the last reslot
+             */
+            bool needsReslot () const;
+
+            /**
+             * @brief Recompute the slots of all members
+             *
+             * @param pos Positions of the drones, indexed by ID
+             */
+            void reslot (const std::vector<ns3::Vector3D>& pos);
+
+            /**
+             * @brief Slot of a drone, -1 if it has none
+             */
+            int slotOf (int id) const;
+
+            /**
+             * @brief Number of slots of a frame
+             */
+            int numSlots () const;
+
+            /**
+             * @brief Length of a frame
+             */
+            ns3::Time frameLength () const;
+
+            /**
+             * @brief Start of the next unicast sub-slot of a drone
+             *
+             * @param id ID of the drone, must have a slot
+             * @param after the returned time is strictly later than this
+             */
+            ns3::Time nextUnicast (int id, ns3::Time after) const;
+
+            /**
+             * @brief Start of the next broadcast sub-slot of a drone
+             *
+             * @param id ID of the drone, must have a slot
+             * @param after the returned time is strictly later than this
+             */
+            ns3::Time nextBroadcast (int id, ns3::Time after) const;
+
+        private:
+            /**
+             * @brief Next frame time, strictly after after, at offset into the slot of id
+             */
+            int64_t nextStart (int id, int64_t offset, int64_t after) const;
+
+            int64_t            slot_ns; /**< Slot length (ns) */
+            int64_t            guard_ns; /**< Guard time (ns) */
+            double             reuse_dist; /**< Minimum distance (m) between drones sharing a slot */
+            std::vector<int>   slot; /**< Slot of each drone by ID, -1 if none */
+            std::vector<char>  member; /**< Membership of each drone by ID */
+            std::vector<char>  taken; /**< Scratch, slots used by conflicting drones */
+            rnl::SpatialGrid   grid; /**< Member positions of the current reslot */
+            std::vector<int>   nb_start; /**< Scratch, conflicts of drone i are nb_list[nb_start[i], nb_start[i+1]) */
+            std::vector<int>   nb_list; /**< Scratch, conflicting drones of every member in ID order */
+            std::vector<int>   near; /**< Scratch, result of one range query */
+            int                num_slots; /**< Slots of a frame */
+            bool               changed; /**< Membership changed since the last reslot */
+    };
+};
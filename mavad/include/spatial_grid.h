@@ -0,0 +1,122 @@
+/**
+ * @brief Uniform spatial hash grid for range and nearest neighbour queries over the drones
+ */
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+/**
+ * @namespace rnl
+ */
+namespace rnl {
+
+    /**
+     * @brief Buckets drones into square cells of the horizontal plane, hashed by cell
+     * coordinates, so a query only looks at the cells around a point instead of every
+     * drone. Distances are full 3D; the swarm flies at one altitude, so z is not bucketed. \n
+     * Updates are incremental: a drone that stays inside its cell only has its position
+     * rewritten, one that crosses a boundary moves between two buckets in O(1). \n
+     * Query results are in ID order (range) or distance order (nearest), so callers stay
+     * deterministic whatever the bucket order.
+     */
+    class SpatialGrid
+    {
+        public:
+            /**
+             * @brief Construct a new Spatial Grid object
+             *
+             * @param cell Side of a cell (m), queries are cheapest with a radius of about one cell
+             */
+            explicit SpatialGrid (double cell = 4.0);
+
+            /**
+             * @brief Insert a drone or move it to p
+             *
+             * @param id ID of the drone, >= 0
+             * @param p position
+             */
+            void update (int id, const ns3::Vector3D& p);
+
+            /**
+             * @brief Remove a drone, no-op if it is not in the grid
+             */
+            void remove (int id);
+
+            /**
+             * @brief Remove every drone
+             */
+            void clear ();
+
+            /**
+             * @brief Whether the drone is in the grid
+             */
+            bool contains (int id) const;
+
+            /**
+             * @brief Number of drones in the grid
+             */
+            int size () const;
+
+            /**
+             * @brief Side of a cell (m)
+             */
+            double cellSize () const;
+
+            /**
+             * @brief Drones closer than r to p, in ID order
+             *
+             * @param p centre of the query
+             * @param r radius (m)
+             * @param out IDs found, cleared first
+             * @param exclude ID to leave out, usually the drone asking
+             */
+            void inRange (const ns3::Vector3D& p, double r, std::vector<int>* out, int exclude = -1) const;
+
+            /**
+             * @brief The k drones nearest to p, nearest first, ties by ID
+             *
+             * @param p centre of the query
+             * @param k number of drones wanted, fewer if the grid has fewer
+             * @param out IDs found, cleared first
+             * @param exclude ID to leave out, usually the drone asking
+             */
+            void nearest (const ns3::Vector3D& p, int k, std::vector<int>* out, int exclude = -1) const;
+
+            /**
+             * @brief Every pair of drones closer than r, each pair once with first < second,
+             * in ID order
+             *
+             * @param r distance (m)
+             * @param out pairs found, cleared first
+             */
+            void pairsWithin (double r, std::vector<std::pair<int, int>>* out) const;
+
+        private:
+            /**
+             * @brief Cell coordinate of a position along one axis
+             */
+            int32_t cellCoord (double v) const;
+
+            /**
+             * @brief Hash key of a cell
+             */
+            static int64_t key (int32_t cx, int32_t cy);
+
+            /**
+             * @brief Append the drones of the cell (cx, cy) closer than sqrt(r2) to p to out
+             */
+            void scanCell (int32_t cx, int32_t cy, const ns3::Vector3D& p, double r2, int exclude,
+                           std::vector<int>* out) const;
+
+            double                                         cell; /**< Side of a cell (m) */
+            std::unordered_map<int64_t, std::vector<int>>  cells; /**< Drones of each occupied cell */
+            std::vector<ns3::Vector3D>                     pos; /**< Position of each drone by ID */
+            std::vector<int64_t>                           cell_of; /**< Key of the cell of each drone by ID */
+            std::vector<int>                               slot_of; /**< Index of each drone in its bucket, -1 if absent */
+            int                                            count; /**< Drones in the grid */
+    };
+};
@@ -0,0 +1,114 @@
+/**
+ * @brief Structure-of-arrays store of the hot per-drone state of the swarm
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+#include "trajectory.h"
+
+/**
+ * @namespace rnl
+ */
+namespace rnl {
+
+    /**
+     * @brief Per-tick planner state of every drone, one array per field, indexed by drone ID. \n
+     * A DroneSoc carries sockets, ROS handles, message structs with strings, its path
+     * and its neighbour table; the per-tick passes only need a few numbers of each drone,
+     * so those live here and a pass streams through a handful of contiguous arrays instead
+     * of striding over whole DroneSocs. \n
+     * Positions and lookahead cursors are owned here. The state, control and parent of
+     * msg_send, which is still what goes on the wire, are mirrored after each FSM pass
+     * @see DroneSoc::syncState
+     */
+    class SwarmState
+    {
+        public:
+            /**
+             * @brief Construct a new Swarm State object with no drones
+             */
+            SwarmState ();
+
+            /**
+             * @brief Size every array for n drones, resets all fields
+             */
+            void resize (int n);
+
+            /**
+             * @brief Number of drones
+             */
+            int size () const;
+
+            ns3::Vector3D position (int i) const;
+            void setPosition (int i, const ns3::Vector3D& p);
+
+            /**
+             * @brief Point of its path the drone is currently heading to
+             */
+            ns3::Vector3D lookAhead (int i) const;
+
+            /**
+             * @brief Move the lookahead cursor of a drone and cache its point. \n
+             * Must be called whenever the path of the drone changes
+             *
+             * @param i ID of the drone
+             * @param s arc length of the cursor along the path
+             * @param traj path of the drone
+             */
+            void setLookAhead (int i, double s, const rnl::Trajectory& traj);
+
+            /**
+             * @brief Whether the drone has path left after its lookahead
+             */
+            bool hasPathAhead (int i) const;
+
+            /**
+             * @brief Whether the drone has a path at all
+             */
+            bool hasPath (int i) const;
+
+            /**
+             * @brief Flag every drone that is within tol of its lookahead point and has path
+             * left after it. One branch free pass over the arrays
+             *
+             * @param tol distance (m)
+             * @param hit set to 1 for the flagged drones, 0 otherwise, sized to size()
+             */
+            void reachedLookAhead (double tol, std::vector<uint8_t>* hit) const;
+
+            /**
+             * @brief Positions of every drone, in ID order
+             */
+            void positions (std::vector<ns3::Vector3D>* out) const;
+
+            /**
+             * @brief Mirror the message bits of a drone
+             */
+            void setState (int i, int state, int control, int parent);
+
+            /**
+             * @brief Anchor of a drone that is moving to its slot around a parent
+             *
+             * @param i ID of the drone
+             * @param id ID of the anchor
+             * @param p position of the anchor
+             * @param dir circling direction, 1 right, -1 left, 0 behind
+             */
+            void setAnchor (int i, int id, const ns3::Vector3D& p, int dir);
+
+            std::vector<double>  px, py, pz; /**< Current position */
+            std::vector<double>  lx, ly, lz; /**< Lookahead point, the path at la_s */
+            std::vector<double>  la_s; /**< Arc length of the lookahead cursor along the path */
+            std::vector<double>  la_len; /**< Length of the path, -1 without a path */
+            std::vector<int>     state; /**< msg_send.state as of the last FSM pass */
+            std::vector<int>     control; /**< msg_send.control as of the last FSM pass */
+            std::vector<int>     parent; /**< msg_send.p_id as of the last FSM pass */
+            std::vector<int>     anch_id; /**< Anchoring ID if any, -1 otherwise */
+            std::vector<int>     circle_dir; /**< Circling direction around the anchor */
+            std::vector<double>  ax, ay, az; /**< Anchoring position */
+    };
+};
@@ -0,0 +1,94 @@
+/**
+ * @brief Fixed pool of worker threads for the data parallel passes of the planner
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @namespace rnl
+ */
+namespace rnl {
+
+    /**
+     * @brief Runs the iterations of a loop across worker threads, the calling thread
+     * working along. Iterations are handed out one at a time, so uneven ones balance. \n
+     * With one thread, the default, everything runs inline on the caller and no thread is
+     * ever started. \n
+     * The pool does not order anything: a loop body must only touch state of its own
+     * iteration and leave shared side effects to the caller.
+     */
+    class ThreadPool
+    {
+        public:
+            /**
+             * @brief Construct a new Thread Pool object
+             *
+             * @param threads threads running a loop, the caller included
+             */
+            explicit ThreadPool (int threads = 1);
+
+            /**
+             * @brief Stop and join the workers
+             */
+            ~ThreadPool ();
+
+            ThreadPool (const ThreadPool&) = delete;
+            ThreadPool& operator= (const ThreadPool&) = delete;
+
+            /**
+             * @brief Stop the workers and start threads - 1 new ones, not during a loop
+             *
+             * @param threads threads running a loop, the caller included; 0 takes the hardware concurrency
+             */
+            void start (int threads);
+
+            /**
+             * @brief Threads running a loop, the caller included
+             */
+            int size () const;
+
+            /**
+             * @brief Run fn (0) .. fn (n-1) and return when all are done
+             *
+             * @param n number of iterations
+             * @param fn loop body, must not throw
+             */
+            void parallelFor (int n, const std::function<void (int)>& fn);
+
+        private:
+            /**
+             * @brief Body of a worker thread
+             *
+             * @param seen generation when the worker was started, later loops are its work
+             */
+            void work (uint64_t seen);
+
+            /**
+             * @brief Take iterations of the current loop until none are left
+             */
+            void runJob ();
+
+            /**
+             * @brief Stop and join the workers
+             */
+            void stopWorkers ();
+
+            std::vector<std::thread>           workers; /**< Worker threads, size () - 1 of them */
+            std::mutex                         mtx; /**< Guards the fields below up to next */
+            std::condition_variable            cv_start; /**< A loop was posted or the pool stops */
+            std::condition_variable            cv_done; /**< The last worker finished the loop */
+            const std::function<void (int)>*   job; /**< Body of the current loop */
+            int                                job_n; /**< Iterations of the current loop */
+            int                                pending; /**< Workers not yet done with the current loop */
+            uint64_t                           generation; /**< Loops posted so far */
+            bool                               stopping; /**< Workers must exit */
+            std::atomic<int>                   next; /**< Next iteration to hand out */
+    };
+};
@@ -0,0 +1,138 @@
+/**
+ * @brief Parametric path of a drone: line and arc segments addressed by arc length
+ */
+#pragma once
+
+#include <vector>
+
+#include "ns3/core-module.h"
+
+/**
+ * @namespace rnl
+ */
+namespace rnl {
+
+    /**
+     * @brief A path as a sequence of segments joined end to start, each a straight line or
+     * a circular arc in the horizontal plane. A point of the path is addressed by its arc
+     * length s from the start, in [0, length ()]. \n
+     * A straight flight is one segment and a lawnmower pattern one segment per leg, so a
+     * path costs a few dozen bytes per leg whatever its length, instead of a waypoint every
+     * STEP. There is no limit on the length of a path.
+     */
+    class Trajectory
+    {
+        public:
+            /**
+             * @enum Kind
+             * @brief Shape of a segment
+             */
+            enum class Kind
+            {
+                LINE,
+                ARC
+            };
+
+            /**
+             * @brief One segment of the path
+             */
+            struct Segment
+            {
+                Kind          kind;
+                ns3::Vector3D a; /**< LINE: start point, ARC: centre of the circle */
+                ns3::Vector3D b; /**< LINE: end point, ARC: start point */
+                double        sweep; /**< ARC: signed angle (rad), positive counter clockwise */
+                double        s0; /**< Arc length at the start of the segment */
+                double        len; /**< Arc length of the segment */
+            };
+
+            /**
+             * @brief Construct a new Trajectory object, empty
+             */
+            Trajectory ();
+
+            /**
+             * @brief Remove every segment
+             */
+            void clear ();
+
+            /**
+             * @brief Replace the path by a single point, a zero length segment
+             */
+            void hold (const ns3::Vector3D& p);
+
+            /**
+             * @brief Append a straight line from the end of the path, or from from if the path
+             * is empty or ends elsewhere
+             *
+             * @param from start of the line
+             * @param to end of the line
+             */
+            void line (const ns3::Vector3D& from, const ns3::Vector3D& to);
+
+            /**
+             * @brief Append straight lines through every point, starting at the end of the path
+             *
+             * @param pts corners of the polyline, the first one is joined to the end of the path
+             */
+            void polyline (const std::vector<ns3::Vector3D>& pts);
+
+            /**
+             * @brief Append an arc around centre from the end of the path, at constant height
+             *
+             * @param centre centre of the circle
+             * @param sweep signed angle to turn (rad), positive counter clockwise
+             */
+            void arc (const ns3::Vector3D& centre, double sweep);
+
+            /**
+             * @brief Whether there is no segment
+             */
+            bool empty () const;
+
+            /**
+             * @brief Total arc length
+             */
+            double length () const;
+
+            /**
+             * @brief Number of segments
+             */
+            int size () const;
+
+            /**
+             * @brief First and last point of the path, nothing defined when empty
+             */
+            ns3::Vector3D start () const;
+            ns3::Vector3D end () const;
+
+            /**
+             * @brief Point at arc length s, clamped to the path
+             */
+            ns3::Vector3D pointAt (double s) const;
+
+            /**
+             * @brief Arc length to move a cursor at s to: step further, but not past the end
+             * of the segment s is on, so every corner is passed through
+             *
+             * @param s current arc length
+             * @param step distance to move (m)
+             */
+            double advance (double s, double step) const;
+
+            const std::vector<Segment>& segments () const;
+
+        private:
+            /**
+             * @brief Index of the segment containing s, the last one past the end
+             */
+            int segmentAt (double s) const;
+
+            /**
+             * @brief Append a segment, setting its s0
+             */
+            void append (Segment seg);
+
+            std::vector<Segment> segs; /**< Segments in path order */
+    };
+};
@@ -0,0 +1,52 @@
+#include "buffer_pool.h"
+
+rnl::BufferPool::Lease::Lease (BufferPool* p, Slot* s): pool {p}, slot {s}
+{
+}
+
+rnl::BufferPool::Lease::Lease (Lease&& other): pool {other.pool}, slot {other.slot}
+{
+    other.pool = nullptr;
+    other.slot = nullptr;
+}
+
+rnl::BufferPool::Lease::~Lease ()
+{
+    if (pool)
+        pool->release (slot);
+}
+
+rnl::BufferPool::BufferPool (size_t reserve): reserve_bytes {reserve}
+{
+}
+
+rnl::BufferPool::Lease rnl::BufferPool::acquire ()
+{
+    st.acquired++;
+    if (free_slots.empty ())
+    {
+        slots.emplace_back (new Slot);
+        slots.back ()->buf.reserve (reserve_bytes);
+        free_slots.push_back (slots.back ().get ());
+        st.allocations++;
+        st.buffers = slots.size ();
+    }
+
+    Slot* s = free_slots.back ();
+    free_slots.pop_back ();
+    s->buf.clear ();
+    s->cap = s->buf.capacity ();
+    return Lease (this, s);
+}
+
+void rnl::BufferPool::release (Slot* s)
+{
+    if (s->buf.capacity () > s->cap)
+        st.allocations++;
+    free_slots.push_back (s);
+}
+
+const rnl::BufferPool::Stats& rnl::BufferPool::stats () const
+{
+    return st;
+}
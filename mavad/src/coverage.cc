@@ -0,0 +1,205 @@
+#include "coverage.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+rnl::Coverage::Coverage (double width): sweep{width}
+{
+}
+
+bool rnl::Coverage::parsePolygon (const std::string& text, Polygon* area)
+{
+    Polygon           _area;
+    std::stringstream _ss (text);
+    std::string       _vertex;
+    while (std::getline (_ss, _vertex, ';'))
+    {
+        double _x, _y;
+        char   _comma, _rest;
+        std::stringstream _vs (_vertex);
+        if (!(_vs >> _x >> _comma >> _y) || _comma != ',' || (_vs >> _rest))
+            return false;
+        _area.push_back (ns3::Vector3D (_x, _y, 0));
+    }
+    if (_area.size () < 3)
+        return false;
+    *area = _area;
+    return true;
+}
+
+void rnl::Coverage::setWidth (double width)
+{
+    sweep = width;
+}
+
+double rnl::Coverage::width () const
+{
+    return sweep;
+}
+
+std::vector<rnl::Coverage::Lane> rnl::Coverage::lanes (const Polygon& area, double width)
+{
+    std::vector<Lane> _lanes;
+    if (area.size () < 3 || width <= 0)
+        return _lanes;
+
+    double _ymin = area[0].y;
+    double _ymax = area[0].y;
+    for (const ns3::Vector3D& _p : area)
+    {
+        _ymin = std::min (_ymin, _p.y);
+        _ymax = std::max (_ymax, _p.y);
+    }
+
+    /* Enough scan lines to cover the height, centred on the area */
+    int    _count = std::max (1, static_cast<int> (std::ceil ((_ymax - _ymin) / width - 1e-9)));
+    double _y0    = _ymin + ((_ymax - _ymin) - (_count - 1) * width) / 2;
+
+    std::vector<double> _xs;
+    for (int k = 0; k < _count; ++k)
+    {
+        double _y = _y0 + k * width;
+        _xs.clear ();
+        for (size_t i = 0; i < area.size (); ++i)
+        {
+            const ns3::Vector3D& _p = area[i];
+            const ns3::Vector3D& _q = area[(i + 1) % area.size ()];
+            /* Half open in y, so a scan line through a vertex crosses once */
+            if ((_p.y <= _y) != (_q.y <= _y))
+            {
+                _xs.push_back (_p.x + (_y - _p.y) * (_q.x - _p.x) / (_q.y - _p.y));
+            }
+        }
+        std::sort (_xs.begin (), _xs.end ());
+        for (size_t i = 0; i + 1 < _xs.size (); i += 2)
+        {
+            if (_xs[i + 1] > _xs[i])
+                _lanes.push_back (Lane {_y, _xs[i], _xs[i + 1]});
+        }
+    }
+    return _lanes;
+}
+
+void rnl::Coverage::assign (const Polygon& area, const std::vector<int>& ids,
+                            const std::vector<ns3::Vector3D>& from, double now)
+{
+    const int _n = static_cast<int> (ids.size ());
+    if (_n == 0)
+        return;
+    std::vector<Lane> _lanes = lanes (area, sweep);
+
+    double _total = 0;
+    for (const Lane& _l : _lanes)
+    {
+        _total += _l.x1 - _l.x0;
+    }
+
+    /* Bottom scanner takes the bottom band */
+    std::vector<int> _order (_n);
+    for (int j = 0; j < _n; ++j)
+    {
+        _order[j] = j;
+    }
+    std::stable_sort (_order.begin (), _order.end (), [&from] (int a, int b) { return from[a].y < from[b].y; });
+
+    /* A lane goes to the band its middle falls in, by length along the lanes */
+    std::vector<std::vector<Lane>> _bands (_n);
+    double _done = 0;
+    for (const Lane& _l : _lanes)
+    {
+        double _len = _l.x1 - _l.x0;
+        int    _b   = std::min (_n - 1, static_cast<int> ((_done + _len / 2) * _n / _total));
+        _bands[_b].push_back (_l);
+        _done += _len;
+    }
+
+    for (int j = 0; j < _n; ++j)
+    {
+        const int                _i    = _order[j];
+        const std::vector<Lane>& _band = _bands[j];
+        const ns3::Vector3D&     _from = from[_i];
+
+        if (!assigned (ids[_i]))
+        {
+            scanner_ids.insert (std::upper_bound (scanner_ids.begin (), scanner_ids.end (), ids[_i]), ids[_i]);
+        }
+        Plan& _plan     = plans[ids[_i]];
+        _plan           = Plan {};
+        _plan.assigned  = now;
+        _plan.first_lap = -1;
+        _plan.last_lap  = -1;
+        _plan.lanes     = static_cast<int> (_band.size ());
+
+        if (_band.empty ())
+        {
+            _plan.traj.hold (_from);
+            continue;
+        }
+
+        ns3::Vector3D _start (_band[0].x0, _band[0].y, _from.z);
+        _plan.traj.line (_from, _start);
+        _plan.cycle_s0 = _plan.traj.length ();
+        for (size_t k = 0; k < _band.size (); ++k)
+        {
+            /* Every other lane is flown backwards */
+            const Lane&   _l = _band[k];
+            ns3::Vector3D _a (k % 2 ? _l.x1 : _l.x0, _l.y, _from.z);
+            ns3::Vector3D _b (k % 2 ? _l.x0 : _l.x1, _l.y, _from.z);
+            _plan.traj.line (_a, _b);
+            _plan.scan_len += _l.x1 - _l.x0;
+        }
+        _plan.traj.line (_plan.traj.end (), _start);
+    }
+}
+
+bool rnl::Coverage::assigned (int id) const
+{
+    return plans.count (id) > 0;
+}
+
+bool rnl::Coverage::scans (int id) const
+{
+    auto _it = plans.find (id);
+    return _it != plans.end () && _it->second.lanes > 0;
+}
+
+const rnl::Trajectory& rnl::Coverage::path (int id) const
+{
+    return plans.at (id).traj;
+}
+
+double rnl::Coverage::cycleStart (int id) const
+{
+    return plans.at (id).cycle_s0;
+}
+
+const std::vector<int>& rnl::Coverage::scanners () const
+{
+    return scanner_ids;
+}
+
+void rnl::Coverage::lapDone (int id, double now)
+{
+    Plan& _plan = plans.at (id);
+    _plan.laps++;
+    if (_plan.first_lap < 0)
+        _plan.first_lap = now;
+    _plan.last_lap = now;
+}
+
+void rnl::Coverage::report (const std::string& path) const
+{
+    std::ofstream out (path.c_str ());
+    out << "drone,lanes,area_m2,cycle_m,cycles,first_cycle_s,rate_m2_s" << std::endl;
+    for (const auto& _p : plans)
+    {
+        const Plan& _plan = _p.second;
+        double      _area = _plan.scan_len * sweep;
+        double      _span = _plan.last_lap - _plan.assigned;
+        out << _p.first << "," << _plan.lanes << "," << _area << "," << _plan.traj.length () - _plan.cycle_s0
+            << "," << _plan.laps << "," << (_plan.first_lap < 0 ? -1 : _plan.first_lap - _plan.assigned)
+            << "," << (_plan.laps > 0 && _span > 0 ? _plan.laps * _area / _span : 0) << std::endl;
+    }
+}
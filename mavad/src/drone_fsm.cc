@@ -0,0 +1,53 @@
+#include "drone_fsm.h"
+
+#include <fstream>
+#include <iostream>
+
+const char* rnl::fsmName (FsmPhase phase)
+{
+    static const char* const names[] = {"free", "changing_parent", "anchoring", "settled"};
+    return phase < FsmPhase::COUNT ? names[static_cast<int> (phase)] : "?";
+}
+
+const char* rnl::fsmName (FsmEvent event)
+{
+    static const char* const names[] = {"hold_rc", "change_parent", "recruit_right", "recruit_left",
+                                        "recruit_behind", "slot_reached", "centre_arrived", "kid_pending",
+                                        "cluster_complete", "relay", "relay_request"};
+    return event < FsmEvent::COUNT ? names[static_cast<int> (event)] : "?";
+}
+
+rnl::FsmStats::FsmStats ()
+{
+    for (auto& _row : counts)
+        _row.fill (0);
+    for (auto& _row : seconds)
+        _row.fill (0.0);
+}
+
+void rnl::FsmStats::record (FsmPhase phase, FsmEvent event, double _seconds)
+{
+    counts[static_cast<int> (phase)][static_cast<int> (event)]++;
+    seconds[static_cast<int> (phase)][static_cast<int> (event)] += _seconds;
+}
+
+uint64_t rnl::FsmStats::count (FsmPhase phase, FsmEvent event) const
+{
+    return counts[static_cast<int> (phase)][static_cast<int> (event)];
+}
+
+void rnl::FsmStats::write (const std::string& path) const
+{
+    std::ofstream csv (path.c_str ());
+    csv << "phase,event,count,total_s,mean_us" << std::endl;
+    uint64_t _total = 0;
+    for (const FsmTransition& _tr : FSM_TRANSITIONS)
+    {
+        uint64_t _n = count (_tr.from, _tr.event);
+        double   _s = seconds[static_cast<int> (_tr.from)][static_cast<int> (_tr.event)];
+        csv << fsmName (_tr.from) << "," << fsmName (_tr.event) << "," << _n << "," << _s << ","
+            << (_n ? _s * 1e6 / _n : 0) << std::endl;
+        _total += _n;
+    }
+    std::cerr << "FSM: " << _total << " transitions, written to " << path << std::endl;
+}
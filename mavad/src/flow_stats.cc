@@ -0,0 +1,118 @@
+#include "flow_stats.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+rnl::FlowStats::FlowStats ()
+{
+}
+
+void rnl::FlowStats::install (ns3::Time _interval)
+{
+    interval = _interval;
+    monitor  = helper.InstallAll ();
+    ns3::Simulator::Schedule (interval, &rnl::FlowStats::snapshot, this);
+}
+
+bool rnl::FlowStats::installed () const
+{
+    return static_cast<bool> (monitor);
+}
+
+std::string rnl::FlowStats::flowKind (uint8_t protocol, uint16_t port)
+{
+    if (protocol == 17 && port == 9)
+        return "control";
+    if (protocol == 6 && port == 8080)
+        return "offload_tcp";
+    if (protocol == 17 && port == 8081)
+        return "offload_udp";
+    return "other";
+}
+
+void rnl::FlowStats::snapshot ()
+{
+    take ();
+    ns3::Simulator::Schedule (interval, &rnl::FlowStats::snapshot, this);
+}
+
+void rnl::FlowStats::take ()
+{
+    if (!monitor)
+        return;
+    monitor->CheckForLostPackets ();
+
+    double _now = ns3::Simulator::Now ().GetSeconds ();
+    for (const auto& _f : monitor->GetFlowStats ())
+    {
+        const ns3::FlowMonitor::FlowStats& _st = _f.second;
+        snapshots.push_back (Snapshot {_now, _f.first, _st.txPackets, _st.rxPackets, _st.lostPackets, _st.rxBytes,
+                                       _st.delaySum.GetSeconds (), _st.jitterSum.GetSeconds ()});
+    }
+}
+
+void rnl::FlowStats::write (const std::string& prefix)
+{
+    if (!monitor)
+        return;
+    take ();
+
+    ns3::Ptr<ns3::Ipv4FlowClassifier> _cls = ns3::DynamicCast<ns3::Ipv4FlowClassifier> (helper.GetClassifier ());
+    std::ofstream csv ((prefix + ".csv").c_str ());
+    std::ofstream json ((prefix + ".json").c_str ());
+    csv << "flow,kind,src,dst,proto,dport,tx_packets,rx_packets,lost_packets,tx_bytes,rx_bytes,"
+        << "throughput_bps,mean_delay_s,mean_jitter_s" << std::endl;
+    json << "{\"flows\":[";
+
+    bool _first = true;
+    for (const auto& _f : monitor->GetFlowStats ())
+    {
+        const ns3::FlowMonitor::FlowStats& _st = _f.second;
+        ns3::Ipv4FlowClassifier::FiveTuple _t  = _cls->FindFlow (_f.first);
+        std::string _kind   = flowKind (_t.protocol, _t.destinationPort);
+        double      _span   = (_st.timeLastRxPacket - _st.timeFirstTxPacket).GetSeconds ();
+        double      _thr    = _span > 0 ? _st.rxBytes * 8.0 / _span : 0;
+        double      _delay  = _st.rxPackets ? _st.delaySum.GetSeconds () / _st.rxPackets : 0;
+        double      _jitter = _st.rxPackets > 1 ? _st.jitterSum.GetSeconds () / (_st.rxPackets - 1) : 0;
+
+        std::ostringstream _src, _dst;
+        _src << _t.sourceAddress;
+        _dst << _t.destinationAddress;
+
+        csv << _f.first << "," << _kind << "," << _src.str () << "," << _dst.str () << "," << static_cast<int> (_t.protocol)
+            << "," << _t.destinationPort << "," << _st.txPackets << "," << _st.rxPackets << "," << _st.lostPackets
+            << "," << _st.txBytes << "," << _st.rxBytes << "," << _thr << "," << _delay << "," << _jitter << std::endl;
+
+        json << (_first ? "" : ",") << "{\"flow\":" << _f.first << ",\"kind\":\"" << _kind << "\",\"src\":\"" << _src.str ()
+             << "\",\"dst\":\"" << _dst.str () << "\",\"proto\":" << static_cast<int> (_t.protocol)
+             << ",\"dport\":" << _t.destinationPort << ",\"tx_packets\":" << _st.txPackets
+             << ",\"rx_packets\":" << _st.rxPackets << ",\"lost_packets\":" << _st.lostPackets
+             << ",\"rx_bytes\":" << _st.rxBytes << ",\"throughput_bps\":" << _thr << ",\"mean_delay_s\":" << _delay
+             << ",\"mean_jitter_s\":" << _jitter << ",\"delay_hist\":[";
+        /* Only the bins that have packets, as [start, width, count] */
+        bool _first_bin = true;
+        for (uint32_t b = 0; b < _st.delayHistogram.GetNBins (); ++b)
+        {
+            if (!_st.delayHistogram.GetBinCount (b))
+                continue;
+            json << (_first_bin ? "" : ",") << "[" << _st.delayHistogram.GetBinStart (b) << ","
+                 << _st.delayHistogram.GetBinWidth (b) << "," << _st.delayHistogram.GetBinCount (b) << "]";
+            _first_bin = false;
+        }
+        json << "]}";
+        _first = false;
+    }
+    json << "]}" << std::endl;
+
+    std::ofstream snap ((prefix + "_snapshots.csv").c_str ());
+    snap << "t,flow,tx_packets,rx_packets,lost_packets,rx_bytes,delay_sum_s,jitter_sum_s" << std::endl;
+    for (const auto& _s : snapshots)
+    {
+        snap << _s.t << "," << _s.flow << "," << _s.tx_packets << "," << _s.rx_packets << "," << _s.lost_packets
+             << "," << _s.rx_bytes << "," << _s.delay_sum << "," << _s.jitter_sum << std::endl;
+    }
+
+    std::cerr << "FlowStats: " << monitor->GetFlowStats ().size () << " flows, " << snapshots.size ()
+              << " snapshot rows, written to " << prefix << ".{csv,json} and " << prefix << "_snapshots.csv" << std::endl;
+}
@@ -0,0 +1,197 @@
+#include "formation.h"
+
+#include <algorithm>
+
+rnl::Formation::Formation (Shape shape, int _num_nodes, int arms, double spacing): num_nodes{_num_nodes}
+{
+    /* The tail and the base node get no slot */
+    int _slots = std::min (std::max (num_nodes - 2, 1), std::max (num_nodes, 0));
+    int _arms  = shape == Shape::T || shape == Shape::RING ? 1 : shape == Shape::LINE ? 0 : std::max (arms, 0);
+    int _size  = 1 + 2 * _arms;
+    int _num_c = (_slots + _size - 1) / _size;
+
+    /* The inward arms of a ring are spacing apart along the circle, the centres one spacing
+       further out, so no two slots of a ring come closer than spacing */
+    double _radius = _num_c > 1 ? spacing + spacing / (2 * std::sin (M_PI / _num_c)) : spacing;
+
+    /* Tolerances of the pci t_formation, tuned per drone */
+    static const double _t_tol[] = {0.4, 0.8, 0.6, 0.5, 1.0, 0.6};
+    auto _tol = [shape] (int id) {
+        return shape == Shape::T && id < 6 ? _t_tol[id] : rnl::SITE_TOL;
+    };
+
+    slots.resize (_slots);
+    centre_idx.assign (_slots, -1);
+    for (int id = 0, k = 0; id < _slots; ++k)
+    {
+        ns3::Vector3D _c ((1 - k) * spacing, 0, 0);
+        ns3::Vector3D _out (0, 1, 0);
+        if (shape == Shape::RING)
+        {
+            double _th = 2 * M_PI * k / _num_c;
+            _c   = ns3::Vector3D (_radius * std::cos (_th), _radius * std::sin (_th), 0);
+            _out = ns3::Vector3D (std::cos (_th), std::sin (_th), 0);
+        }
+
+        int _centre = id;
+        slots[id]   = Slot {_c, _centre, 0, -1, _tol (id)};
+        centre_idx[id] = static_cast<int> (centre_ids.size ());
+        centre_ids.push_back (id);
+        kids.emplace_back ();
+        ++id;
+
+        /* Arms alternate left, right, moving outwards */
+        int _inner[2] = {_centre, _centre};
+        for (int j = 1; j <= _arms; ++j)
+        {
+            for (int s : {1, -1})
+            {
+                if (id >= _slots)
+                    break;
+                ns3::Vector3D _o (_c.x + s * j * spacing * _out.x, _c.y + s * j * spacing * _out.y, 0);
+                int& _in  = _inner[s > 0 ? 0 : 1];
+                slots[id] = Slot {_o, _centre, s, _in, _tol (id)};
+                _in       = id;
+                kids.back ().push_back (id);
+                ++id;
+            }
+        }
+        if (id < _slots)
+        {
+            kids.back ().push_back (id);
+        }
+    }
+
+    for (int i = 0; i < _slots; ++i)
+    {
+        for (int j = 0; j < i; ++j)
+        {
+            NS_ASSERT_MSG (ns3::CalculateDistance (slots[i].offset, slots[j].offset) > spacing * (1 - 1e-9),
+                           "Formation slots " << j << " and " << i << " closer than spacing");
+        }
+    }
+}
+
+bool rnl::Formation::parseShape (const std::string& name, Shape* shape)
+{
+    if (name == "t")
+        *shape = Shape::T;
+    else if (name == "line")
+        *shape = Shape::LINE;
+    else if (name == "grid")
+        *shape = Shape::GRID;
+    else if (name == "ring")
+        *shape = Shape::RING;
+    else
+        return false;
+    return true;
+}
+
+int rnl::Formation::numSlots () const
+{
+    return static_cast<int> (slots.size ());
+}
+
+int rnl::Formation::tailId () const
+{
+    return numSlots ();
+}
+
+int rnl::Formation::baseId () const
+{
+    return num_nodes - 1;
+}
+
+bool rnl::Formation::hasSlot (int id) const
+{
+    return id >= 0 && id < numSlots ();
+}
+
+bool rnl::Formation::isCentre (int id) const
+{
+    return hasSlot (id) && slots[id].side == 0;
+}
+
+bool rnl::Formation::isArm (int id) const
+{
+    return hasSlot (id) && slots[id].side != 0;
+}
+
+int rnl::Formation::centreOf (int id) const
+{
+    return hasSlot (id) ? slots[id].centre : -1;
+}
+
+int rnl::Formation::side (int id) const
+{
+    return hasSlot (id) ? slots[id].side : 0;
+}
+
+int rnl::Formation::prevCentre (int centre) const
+{
+    int k = isCentre (centre) ? centre_idx[centre] : 0;
+    return k > 0 ? centre_ids[k - 1] : -1;
+}
+
+int rnl::Formation::nextCentre (int centre) const
+{
+    if (!isCentre (centre))
+        return -1;
+    size_t k = centre_idx[centre] + 1;
+    return k < centre_ids.size () ? centre_ids[k] : -1;
+}
+
+const std::vector<int>& rnl::Formation::centres () const
+{
+    return centre_ids;
+}
+
+const std::vector<int>& rnl::Formation::children (int centre) const
+{
+    static const std::vector<int> none;
+    return isCentre (centre) ? kids[centre_idx[centre]] : none;
+}
+
+int rnl::Formation::recruitControl (int id) const
+{
+    int s = side (id);
+    return s > 0 ? CLTOP : s < 0 ? CRTOP : CBTOP;
+}
+
+ns3::Vector3D rnl::Formation::offset (int id) const
+{
+    return hasSlot (id) ? slots[id].offset : ns3::Vector3D ();
+}
+
+ns3::Vector3D rnl::Formation::offsetFromParent (int id) const
+{
+    int _parent = isArm (id) ? slots[id].centre : prevCentre (id);
+    return _parent < 0 ? ns3::Vector3D () : offset (id) - offset (_parent);
+}
+
+ns3::Vector3D rnl::Formation::slotPos (int id, const ns3::Vector3D& site) const
+{
+    return site + offset (id);
+}
+
+double rnl::Formation::tolerance (int id) const
+{
+    return hasSlot (id) ? slots[id].tol : 0;
+}
+
+bool rnl::Formation::siteReached (const ns3::Vector3D& pos, int id, const ns3::Vector3D& site) const
+{
+    return hasSlot (id) && ns3::CalculateDistance (pos, slotPos (id, site)) < slots[id].tol;
+}
+
+int rnl::Formation::towardBase (int id) const
+{
+    if (isArm (id))
+        return slots[id].inner;
+    if (isCentre (id))
+    {
+        int _next = nextCentre (id);
+        return _next >= 0 ? _next : tailId ();
+    }
+    return id + 1 < num_nodes ? id + 1 : -1;
+}
@@ -23,10 +23,65 @@ int main(int argc, char **argv){
     ros::NodeHandle nh;
     ros::NodeHandle nh_private("~");
 
+    bool textWire = false;
+    bool eventDriven = false;
+    std::string payload = "imagery";
+    std::string transport = "tcp";
+    rnl::Offload::Config offload;
+    double flowInterval = 0;
+    int numNodes = 8;
+    std::string formationName = "t";
+    int formationArms = 2;
+    int planThreads = 1;
+    std::string scanArea = "";
+    double sweepWidth = rnl::SWEEP_WIDTH;
+    int dropDrone = -1;
+    double dropAt = 0;
+    double dropFor = 0;
+    CommandLine cmd;
+    cmd.AddValue ("textWire", "Use the text wire format for USMsg/URMsg instead of the binary one (debugging)", textWire);
+    cmd.AddValue ("eventDriven", "Re-evaluate only drones with new packets, movement or timers each tick", eventDriven);
+    cmd.AddValue ("payload", "Offload payload model: imagery, video or telemetry", payload);
+    cmd.AddValue ("transport", "Offload transport: tcp or udp", transport);
+    cmd.AddValue ("tcpCc", "TCP congestion control of the offload, eg ns3::TcpNewReno, ns3::TcpCubic", offload.tcp_cc);
+    cmd.AddValue ("segmentSize", "Offload segment (TCP) or datagram (UDP) size in bytes", offload.segment);
+    cmd.AddValue ("imageBytes", "Size of one image of the imagery payload in bytes", offload.image_bytes);
+    cmd.AddValue ("videoRate", "Rate of the video payload", offload.video_rate);
+    cmd.AddValue ("numNodes", "Nodes of the swarm: the drones, the tail relay and the base node", numNodes);
+    cmd.AddValue ("formation", "Formation over the site: t, line, grid or ring", formationName);
+    cmd.AddValue ("formationArms", "Arms on each side of a centre in the grid formation", formationArms);
+    cmd.AddValue ("flowStats", "Snapshot per flow FlowMonitor statistics every this many seconds, 0 disables", flowInterval);
+    cmd.AddValue ("planThreads", "Threads planning the drones each tick, 0 for one per core", planThreads);
+    cmd.AddValue ("scanArea", "Area each cluster scans, x,y;x,y;... relative to its centre slot, empty for a box around each arm", scanArea);
+    cmd.AddValue ("sweepWidth", "Distance (m) between two lanes of the coverage paths", sweepWidth);
+    cmd.AddValue ("dropDrone", "Drone that leaves the TDMA schedule at dropAt and joins again dropFor later, -1 for none", dropDrone);
+    cmd.AddValue ("dropAt", "Simulation time (s) the drop out drone leaves", dropAt);
+    cmd.AddValue ("dropFor", "Seconds the drop out drone stays away", dropFor);
+    cmd.Parse (argc, argv);
+    rnl::WIRE_FORMAT = textWire ? rnl::WireFormat::TEXT : rnl::WireFormat::BINARY;
+    if (!rnl::Offload::parsePayload (payload, &offload.payload) || (transport != "tcp" && transport != "udp"))
+    {
+        std::cerr << "Unknown payload " << payload << " or transport " << transport << std::endl;
+        return 1;
+    }
+    offload.tcp = transport == "tcp";
+    rnl::Formation::Shape shape;
+    if (!rnl::Formation::parseShape (formationName, &shape) || numNodes < 3)
+    {
+        std::cerr << "Unknown formation " << formationName << " or fewer than 3 nodes" << std::endl;
+        return 1;
+    }
+    rnl::Coverage::Polygon area;
+    if ((!scanArea.empty () && !rnl::Coverage::parsePolygon (scanArea, &area)) || sweepWidth <= 0)
+    {
+        std::cerr << "Malformed scan area " << scanArea << " or sweep width " << sweepWidth << std::endl;
+        return 1;
+    }
+
     /**
      * Create an object of properties, give phyMode, rss value and number of nodes 
      */
-    Properties prop ("DsssRate11Mbps",-80, 8);
+    Properties prop ("DsssRate11Mbps",-80, numNodes);
     prop.initialize(true, true); /**< Initializing with realtime simulation and with checksum enabled*/
     prop.setWifi (false, true); /**<Set wifi without debug and enable pcap and ascii tracing*/
     prop.setInternet (); /**< Set IP*/
@@ -34,7 +89,14 @@ int main(int argc, char **argv){
     /**
      * Create and start a Planner 
      */
-    rnl::Planner plan (nh, nh_private, prop, 8, 0.2, 0.1, 2500.0);
+    rnl::Planner plan (nh, nh_private, prop, numNodes, 0.2, 0.1, 2500.0);
+    plan.setFormation (rnl::Formation (shape, numNodes, formationArms));
+    plan.setEventDriven (eventDriven);
+    plan.setOffload (offload);
+    plan.setFlowStats (Seconds (flowInterval));
+    plan.setPlanThreads (planThreads);
+    plan.setCoverage (area, sweepWidth);
+    plan.setDropout (dropDrone, Seconds (dropAt), Seconds (dropFor));
     plan.initializeSockets ();
     plan.startSimul();
     return 0;
@@ -0,0 +1,228 @@
+#include "offload.h"
+#include "planner_config.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    const uint16_t TCP_PORT = 8080;
+    const uint16_t UDP_PORT = 8081;
+}
+
+rnl::Offload::Offload ()
+{
+}
+
+void rnl::Offload::configure (const Config& _cfg)
+{
+    cfg = _cfg;
+}
+
+bool rnl::Offload::parsePayload (const std::string& name, Payload* payload)
+{
+    if (name == "imagery")
+        *payload = Payload::IMAGERY;
+    else if (name == "video")
+        *payload = Payload::VIDEO;
+    else if (name == "telemetry")
+        *payload = Payload::TELEMETRY;
+    else
+        return false;
+    return true;
+}
+
+void rnl::Offload::installSink (ns3::Ptr<ns3::Node> node, ns3::Time start, ns3::Time stop)
+{
+    if (cfg.tcp)
+    {
+        /* The stacks exist already, so set the congestion control on them rather than as a default */
+        ns3::Config::Set ("/NodeList/*/$ns3::TcpL4Protocol/SocketType", ns3::TypeIdValue (ns3::TypeId::LookupByName (cfg.tcp_cc)));
+        ns3::Config::SetDefault ("ns3::TcpSocket::SegmentSize", ns3::UintegerValue (cfg.segment));
+    }
+
+    ns3::PacketSinkHelper tcp_helper ("ns3::TcpSocketFactory", ns3::InetSocketAddress (ns3::Ipv4Address::GetAny (), TCP_PORT));
+    tcp_helper.SetAttribute ("EnableSeqTsSizeHeader", ns3::BooleanValue (true));
+    ns3::ApplicationContainer apps = tcp_helper.Install (node);
+    tcp_sink = apps.Get (0)->GetObject<ns3::PacketSink> ();
+
+    ns3::PacketSinkHelper udp_helper ("ns3::UdpSocketFactory", ns3::InetSocketAddress (ns3::Ipv4Address::GetAny (), UDP_PORT));
+    udp_helper.SetAttribute ("EnableSeqTsSizeHeader", ns3::BooleanValue (true));
+    apps.Add (udp_helper.Install (node));
+    udp_sink = apps.Get (1)->GetObject<ns3::PacketSink> ();
+
+    tcp_sink->TraceConnectWithoutContext ("RxWithSeqTsSize", ns3::MakeCallback (&rnl::Offload::rxTrace, this));
+    udp_sink->TraceConnectWithoutContext ("RxWithSeqTsSize", ns3::MakeCallback (&rnl::Offload::rxTrace, this));
+    apps.Start (start);
+    apps.Stop (stop);
+}
+
+void rnl::Offload::startJob (int drone, ns3::Ptr<ns3::Node> node, const std::string& sink_ip, ns3::Time start)
+{
+    switch (cfg.payload)
+    {
+        case Payload::IMAGERY:
+            for (uint32_t i = 0; i < cfg.images; ++i)
+                installJob (drone, node, sink_ip, start + ns3::Seconds (i * cfg.image_period), cfg.image_bytes);
+            break;
+        case Payload::VIDEO:
+            installJob (drone, node, sink_ip, start,
+                        static_cast<uint64_t> (ns3::DataRate (cfg.video_rate).GetBitRate () * cfg.video_duration / 8));
+            break;
+        case Payload::TELEMETRY:
+            installJob (drone, node, sink_ip, start,
+                        static_cast<uint64_t> (cfg.telemetry_bytes * std::max (1.0, cfg.telemetry_duration / cfg.telemetry_period)));
+            break;
+    }
+}
+
+void rnl::Offload::installJob (int drone, ns3::Ptr<ns3::Node> node, const std::string& sink_ip, ns3::Time start, uint64_t bytes)
+{
+    const char* factory = cfg.tcp ? "ns3::TcpSocketFactory" : "ns3::UdpSocketFactory";
+    ns3::InetSocketAddress remote (ns3::Ipv4Address (sink_ip.c_str ()), cfg.tcp ? TCP_PORT : UDP_PORT);
+    ns3::ApplicationContainer apps;
+    double _window;
+
+    if (cfg.payload == Payload::IMAGERY && cfg.tcp)
+    {
+        /* As fast as the window allows, like the camera dump it models */
+        ns3::BulkSendHelper source (factory, remote);
+        source.SetAttribute ("MaxBytes", ns3::UintegerValue (bytes));
+        source.SetAttribute ("SendSize", ns3::UintegerValue (cfg.segment));
+        source.SetAttribute ("EnableSeqTsSizeHeader", ns3::BooleanValue (true));
+        apps    = source.Install (node);
+        _window = cfg.image_period;
+    }
+    else
+    {
+        uint32_t    _size = cfg.segment;
+        ns3::DataRate _rate (cfg.video_rate);
+        _window = cfg.payload == Payload::VIDEO ? cfg.video_duration : cfg.image_period;
+        if (cfg.payload == Payload::TELEMETRY)
+        {
+            _size   = cfg.telemetry_bytes;
+            _rate   = ns3::DataRate (static_cast<uint64_t> (cfg.telemetry_bytes * 8 / cfg.telemetry_period));
+            _window = cfg.telemetry_duration;
+        }
+
+        ns3::OnOffHelper source (factory, remote);
+        source.SetConstantRate (_rate, _size);
+        source.SetAttribute ("MaxBytes", ns3::UintegerValue (bytes));
+        source.SetAttribute ("EnableSeqTsSizeHeader", ns3::BooleanValue (true));
+        apps = source.Install (node);
+    }
+
+    /* Give the transfer its nominal time plus a second to drain */
+    apps.Start (start);
+    apps.Stop (start + ns3::Seconds (_window + 1));
+
+    DroneStats& _st = statsOf (drone);
+    _st.jobs.push_back (jobs.size ());
+    jobs.push_back (Job {drone, (ns3::Simulator::Now () + start).GetSeconds (), bytes, 0, -1});
+    if (_st.first < 0)
+        _st.first = jobs.back ().start;
+}
+
+rnl::Offload::DroneStats& rnl::Offload::statsOf (int drone)
+{
+    if (static_cast<size_t> (drone) >= drones.size ())
+        drones.resize (drone + 1);
+    return drones[drone];
+}
+
+void rnl::Offload::rxTrace (ns3::Ptr<const ns3::Packet> /*p*/, const ns3::Address& from, const ns3::Address&,
+                            const ns3::SeqTsSizeHeader& header)
+{
+    int _drone = rnl::nodeIndex (ns3::InetSocketAddress::ConvertFrom (from).GetIpv4 ().Get ());
+    if (_drone < 0)
+        return;
+
+    double      _now   = ns3::Simulator::Now ().GetSeconds ();
+    double      _delay = _now - header.GetTs ().GetSeconds ();
+    uint64_t    _bytes = header.GetSize ();
+    DroneStats& _st    = statsOf (_drone);
+
+    _st.bytes     += _bytes;
+    _st.segments  += 1;
+    _st.last       = _now;
+    _st.delay_sum += _delay;
+    _st.delay_max  = std::max (_st.delay_max, _delay);
+
+    while (_bytes > 0 && _st.cursor < _st.jobs.size ())
+    {
+        Job&     _job  = jobs[_st.jobs[_st.cursor]];
+        uint64_t _fill = std::min (_bytes, _job.bytes - _job.rx);
+        _job.rx += _fill;
+        _bytes  -= _fill;
+        if (_job.rx >= _job.bytes)
+        {
+            _job.done = _now;
+            _st.cursor++;
+        }
+    }
+}
+
+ns3::Ptr<ns3::PacketSink> rnl::Offload::tcpSink () const
+{
+    return tcp_sink;
+}
+
+ns3::Ptr<ns3::PacketSink> rnl::Offload::udpSink () const
+{
+    return udp_sink;
+}
+
+void rnl::Offload::report (const std::string& path) const
+{
+    std::ofstream out (path.c_str ());
+    out << "drone,bytes,goodput_bps,jobs,completed,mean_completion_s,mean_delay_s,max_delay_s" << std::endl;
+
+    auto row = [&out] (const std::string& name, uint64_t bytes, double span, size_t njobs, size_t done,
+                       double completion, uint64_t segments, double delay_sum, double delay_max)
+    {
+        out << name << "," << bytes << "," << (span > 0 ? bytes * 8 / span : 0) << "," << njobs << "," << done
+            << "," << (done ? completion / done : 0) << "," << (segments ? delay_sum / segments : 0)
+            << "," << delay_max << std::endl;
+    };
+
+    DroneStats _all;
+    size_t     _all_jobs = 0;
+    size_t     _all_done = 0;
+    double     _all_comp = 0;
+    for (size_t i = 0; i < drones.size (); ++i)
+    {
+        const DroneStats& _st = drones[i];
+        if (_st.jobs.empty () && _st.bytes == 0)
+            continue;
+
+        size_t _done = 0;
+        double _comp = 0;
+        for (size_t j : _st.jobs)
+        {
+            if (jobs[j].done < 0)
+                continue;
+            _done++;
+            _comp += jobs[j].done - jobs[j].start;
+        }
+        row (std::to_string (i), _st.bytes, _st.last - _st.first, _st.jobs.size (), _done, _comp,
+             _st.segments, _st.delay_sum, _st.delay_max);
+
+        _all.bytes     += _st.bytes;
+        _all.segments  += _st.segments;
+        _all.delay_sum += _st.delay_sum;
+        _all.delay_max  = std::max (_all.delay_max, _st.delay_max);
+        _all.last       = std::max (_all.last, _st.last);
+        if (_st.first >= 0 && (_all.first < 0 || _st.first < _all.first))
+            _all.first = _st.first;
+        _all_jobs += _st.jobs.size ();
+        _all_done += _done;
+        _all_comp += _comp;
+    }
+    row ("all", _all.bytes, _all.last - _all.first, _all_jobs, _all_done, _all_comp,
+         _all.segments, _all.delay_sum, _all.delay_max);
+
+    double _span = _all.last - _all.first;
+    std::cerr << "Offload: " << _all.bytes << " bytes, goodput " << (_span > 0 ? _all.bytes * 8 / _span : 0)
+              << " bps, " << _all_done << "/" << _all_jobs << " jobs completed, mean delay "
+              << (_all.segments ? _all.delay_sum / _all.segments : 0) << " s, written to " << path << std::endl;
+}
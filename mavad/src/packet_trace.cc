@@ -0,0 +1,181 @@
+#include "packet_trace.h"
+#include "planner_config.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+    /* How often the writer looks at the ring when nobody wakes it */
+    const std::chrono::milliseconds DRAIN_PERIOD (50);
+
+    size_t roundPow2 (size_t n)
+    {
+        size_t p = 1;
+        while (p < n)
+            p <<= 1;
+        return p;
+    }
+}
+
+rnl::PacketTrace::PacketTrace (size_t capacity):
+ring (roundPow2 (capacity < 2 ? 2 : capacity)), head {0}, tail {0}, running {false}, n_dropped {0}
+{
+    mask      = ring.size () - 1;
+    n_written = 0;
+    file      = nullptr;
+}
+
+rnl::PacketTrace::~PacketTrace ()
+{
+    close ();
+}
+
+bool rnl::PacketTrace::open (const std::string& path)
+{
+    close ();
+    file = std::fopen (path.c_str (), "wb");
+    if (!file)
+    {
+        std::cerr << "PacketTrace: cannot create " << path << std::endl;
+        return false;
+    }
+
+    TraceFileHeader hdr;
+    std::memcpy (hdr.magic, "RNLT", 4);
+    hdr.version     = VERSION;
+    hdr.record_size = sizeof (TraceRecord);
+    hdr.pad         = 0;
+    std::fwrite (&hdr, sizeof (hdr), 1, file);
+
+    head.store (0);
+    tail.store (0);
+    n_dropped.store (0);
+    n_written = 0;
+    running.store (true);
+    writer = std::thread (&rnl::PacketTrace::drain, this);
+    return true;
+}
+
+void rnl::PacketTrace::close ()
+{
+    if (!file)
+        return;
+    {
+        std::lock_guard<std::mutex> lock (wake_mtx);
+        running.store (false);
+    }
+    wake_cv.notify_one ();
+    writer.join ();
+
+    std::fclose (file);
+    file = nullptr;
+    std::cerr << "PacketTrace: " << n_written << " records written, " << n_dropped.load () << " dropped" << std::endl;
+}
+
+void rnl::PacketTrace::record (const TraceRecord& rec)
+{
+    size_t _head = head.load (std::memory_order_relaxed);
+    size_t _tail = tail.load (std::memory_order_acquire);
+    if (!file || _head - _tail > mask)
+    {
+        n_dropped.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring[_head & mask] = rec;
+    head.store (_head + 1, std::memory_order_release);
+
+    /* Nudge the writer once the ring is half full rather than on every record */
+    if (_head - _tail == (mask + 1) / 2)
+        wake_cv.notify_one ();
+}
+
+void rnl::PacketTrace::rxTrace (PacketTrace* trace, uint32_t node, ns3::Ptr<const ns3::Packet> p, const ns3::Address& from)
+{
+    TraceRecord _rec;
+    _rec.t_ns  = ns3::Simulator::Now ().GetNanoSeconds ();
+    _rec.node  = node;
+    _rec.src   = ns3::InetSocketAddress::IsMatchingType (from) ? ns3::InetSocketAddress::ConvertFrom (from).GetIpv4 ().Get () : 0;
+    _rec.bytes = p->GetSize ();
+    _rec.pad   = 0;
+    trace->record (_rec);
+}
+
+uint64_t rnl::PacketTrace::dropped () const
+{
+    return n_dropped.load ();
+}
+
+uint64_t rnl::PacketTrace::written () const
+{
+    return n_written;
+}
+
+size_t rnl::PacketTrace::flush (size_t _tail, size_t _head)
+{
+    /* At most two contiguous runs, before and after the wrap */
+    while (_tail != _head)
+    {
+        size_t _from = _tail & mask;
+        size_t _n    = std::min (_head - _tail, ring.size () - _from);
+        std::fwrite (&ring[_from], sizeof (TraceRecord), _n, file);
+        _tail     += _n;
+        n_written += _n;
+        tail.store (_tail, std::memory_order_release);
+    }
+    return _tail;
+}
+
+void rnl::PacketTrace::drain ()
+{
+    size_t _tail = tail.load ();
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock (wake_mtx);
+            wake_cv.wait_for (lock, DRAIN_PERIOD, [this]
+            {
+                return !running.load () || head.load () - tail.load () > mask / 2;
+            });
+        }
+        bool _last = !running.load ();
+        _tail = flush (_tail, head.load (std::memory_order_acquire));
+        if (_last)
+            break;
+    }
+    std::fflush (file);
+}
+
+bool rnl::PacketTrace::exportText (const std::string& in_path, const std::string& out_path, uint32_t wrap)
+{
+    std::ifstream in (in_path.c_str (), std::ios::binary);
+    TraceFileHeader hdr;
+    if (!in.read (reinterpret_cast<char*> (&hdr), sizeof (hdr)) || std::memcmp (hdr.magic, "RNLT", 4) != 0
+        || hdr.version != VERSION || hdr.record_size != sizeof (TraceRecord))
+    {
+        std::cerr << "PacketTrace: " << in_path << " is not a packet trace" << std::endl;
+        return false;
+    }
+
+    std::ofstream out (out_path.c_str ());
+    std::unordered_map<uint32_t, uint32_t> _count;
+    TraceRecord _rec;
+    while (in.read (reinterpret_cast<char*> (&_rec), sizeof (_rec)))
+    {
+        int       _drone = rnl::nodeIndex (_rec.src);
+        uint32_t& _n     = _count[_rec.src];
+        _n++;
+        out << "At " << _rec.t_ns * 1e-9 << "\t" << "received " << "Pkt No.:" << _n << " (" << _rec.bytes << " bytes)"
+            << " at node" << _rec.node << " from node" << _drone << std::endl;
+        if (wrap && _n == wrap)
+        {
+            _n = 0;
+            out << std::endl;
+        }
+    }
+    return true;
+}
@@ -1,20 +1,86 @@
 #include "planner_config.h"
 
-rnl::USMsg::USMsg (
-    int                      id,
-    int                      dst,
-    const std::string&       n,
-    int                      co, 
-    int                      st,
-    int                      p,
-    int                      neighbour_cnt,
-    ns3::Vector3D            _ploc
-    ): source_id {id}, dst_id {dst}, nbs {n}, control {co},
-        state {st}, p_id {p}, p_loc{_ploc}, neigh_cnt{neighbour_cnt}
+rnl::WireFormat rnl::WIRE_FORMAT = rnl::WireFormat::BINARY;
+
+namespace
 {
+    int64_t quantize (double v)
+    {
+        return static_cast<int64_t> (std::llround (v / rnl::NBT_QUANT));
+    }
+
+    void putQuantVec (std::string* b, int64_t x, int64_t y, int64_t z)
+    {
+        rnl::codec::putVarint (b, rnl::codec::zigzag (x));
+        rnl::codec::putVarint (b, rnl::codec::zigzag (y));
+        rnl::codec::putVarint (b, rnl::codec::zigzag (z));
+    }
+
+    using NbEntries = std::vector<std::pair<int, ns3::Vector3D>>;
+
+    void upsertNb (NbEntries& entries, std::vector<double>& seen, std::vector<int>& idx,
+                   int id, const ns3::Vector3D& pos, double now)
+    {
+        if (id < 0 || id >= rnl::NBT_MAX_ID)
+            return;
+        if (static_cast<size_t> (id) >= idx.size ())
+            idx.resize (id + 1, -1);
+
+        if (idx[id] >= 0)
+        {
+            entries[idx[id]].second = pos;
+            seen[idx[id]]           = now;
+            return;
+        }
+        idx[id] = static_cast<int> (entries.size ());
+        entries.emplace_back (id, pos);
+        seen.push_back (now);
+    }
+
+    const ns3::Vector3D* findNbIn (const NbEntries& entries, const std::vector<int>& idx, int id)
+    {
+        if (id < 0 || static_cast<size_t> (id) >= idx.size () || idx[id] < 0)
+            return nullptr;
+        return &entries[idx[id]].second;
+    }
+
+    /* Swap expired entries with the last one, keeping the index in step */
+    size_t expireNb (NbEntries& entries, std::vector<double>& seen, std::vector<int>& idx,
+                     double deadline)
+    {
+        size_t _dropped = 0;
+        size_t i        = 0;
+        while (i < entries.size ())
+        {
+            if (seen[i] >= deadline)
+            {
+                ++i;
+                continue;
+            }
+            idx[entries[i].first] = -1;
+            if (i + 1 != entries.size ())
+            {
+                entries[i]                    = entries.back ();
+                seen[i]                       = seen.back ();
+                idx[entries[i].first]         = static_cast<int> (i);
+            }
+            entries.pop_back ();
+            seen.pop_back ();
+            ++_dropped;
+        }
+        return _dropped;
+    }
+
+    void clearNb (NbEntries& entries, std::vector<double>& seen, std::vector<int>& idx)
+    {
+        for (const auto& n : entries)
+            idx[n.first] = -1;
+        entries.clear ();
+        seen.clear ();
+    }
 }
 
-rnl::URMsg::URMsg (
+rnl::UMsg::UMsg (
     int                      id,
     int                      dst,
     const std::string&       n,
@@ -24,11 +90,11 @@ rnl::URMsg::URMsg (
     int                      neighbour_cnt,
     ns3::Vector3D            _ploc
     ): source_id {id}, dst_id {dst}, nbs {n}, control {co},
-        state {st}, p_id {p}, p_loc{_ploc}, neigh_cnt{neighbour_cnt}
+        state {st}, p_id {p}, neigh_cnt{neighbour_cnt}, p_loc{_ploc}, ctrl_seq{0}
 {
 }
 
-rnl::USMsg::USMsg ()
+rnl::UMsg::UMsg ()
 {
     source_id  = -998;
     dst_id = -998;
@@ -38,126 +104,132 @@ rnl::USMsg::USMsg ()
     p_id   = -998;
     neigh_cnt = -998;
     p_loc  = ns3::Vector3D (-998,-998,-998);
-	bc_nbs = "";
+    ctrl_seq = 0;
+}
+
+rnl::URMsg::URMsg (
+    int                      id,
+    int                      dst,
+    const std::string&       n,
+    int                      co, 
+    int                      st,
+    int                      p,
+    int                      neighbour_cnt,
+    ns3::Vector3D            _ploc
+    ): UMsg {id, dst, n, co, st, p, neighbour_cnt, _ploc}
+{
+    msg_type = 'u';
+    bc       = {-998, ns3::Vector3D (-998,-998,-998)};
+    ack      = {-998, 0};
 }
 
 rnl::URMsg::URMsg ()
 {
-    source_id  = -998;
-    dst_id = -998;
-    nbs    = "";
-    control= -998;
-    state  = -998;
-    p_id   = -998;
-    neigh_cnt = -998;
-    p_loc  = ns3::Vector3D (-998,-998,-998);
-	bc_nbs = "";
+    msg_type = 'u';
+    bc       = {-998, ns3::Vector3D (-998,-998,-998)};
+    ack      = {-998, 0};
 }
 
 void rnl::USMsg::serialize (std::string* loc)
 {
-    std::stringstream _msg;
-    _msg << "u" << rnl::DELIM;
-    _msg << source_id  << rnl::DELIM
-        << dst_id  << rnl::DELIM
-        << nbs     << rnl::DELIM
-        << control << rnl::DELIM
-        << state   << rnl::DELIM
-        << p_id    << rnl::DELIM
-        << neigh_cnt << rnl::DELIM
-        << std::fixed << p_loc //.x << ":" << std::setprecision(5) << p_loc.y << ":" << std::setprecision(5) << p_loc.z
-        << '\0';
-
-    *loc = _msg.str ();
+    rnl::codec::serialize<rnl::UMsg> (*this, loc);
 }
 
 void rnl::USMsg::serializeBC (std::string* loc, int id, ns3::Vector3D pos)
 {
-    std::stringstream _msg;
-    _msg << "b" << rnl::DELIM;
-    _msg << id  << rnl::DELIM
-    <<   std::fixed << pos << '\0';
-    *loc = _msg.str ();
+    rnl::codec::serialize (rnl::BcMsg {id, pos}, loc);
 }
 
-void rnl::URMsg::parseBroadcast (std::string& msg)
+void rnl::USMsg::serializeAck (std::string* loc, int id, int seq)
 {
-	std::string _tok;
-    std::stringstream _bc_nbs;
-    _tok          = msg.substr(0, msg.find(rnl::DELIM));
-    _bc_nbs << _tok << rnl::DELIM;
-    msg.erase(0, msg.find(rnl::DELIM) + rnl::DELIM.size()); 
-    
-    _tok          = msg.substr(0, msg.find(rnl::DELIM));
-    _bc_nbs << _tok;
-	bc_nbs = _bc_nbs.str();
+    rnl::codec::serialize (rnl::AckMsg {id, seq}, loc);
 }
 
-void rnl::URMsg::parseUnicast (std::string& msg)
+rnl::ParseStatus rnl::URMsg::parse (const uint8_t* data, size_t len)
 {
-	std::string _tok;
-    _tok          = msg.substr(0, msg.find(rnl::DELIM));
-    source_id     = std::stoi(_tok);
-    msg.erase(0, msg.find(rnl::DELIM) + rnl::DELIM.size()); 
-
-    _tok          = msg.substr(0, msg.find(rnl::DELIM));
-    dst_id        = std::stoi(_tok);
-    msg.erase(0, msg.find(rnl::DELIM) + rnl::DELIM.size()); 
+    rnl::ParseStatus _st;
+    switch (rnl::codec::frameType (data, len))
+    {
+        case rnl::Schema<rnl::BcMsg>::type:
+            _st = rnl::codec::parseBody (bc, data, len);
+            if (_st == rnl::ParseStatus::OK)
+                msg_type = rnl::Schema<rnl::BcMsg>::type;
+            return _st;
 
-    _tok          = msg.substr(0, msg.find(rnl::DELIM));
-    nbs           = _tok;
-    msg.erase(0, msg.find(rnl::DELIM) + rnl::DELIM.size()); 
+        case rnl::Schema<rnl::AckMsg>::type:
+            _st = rnl::codec::parseBody (ack, data, len);
+            if (_st == rnl::ParseStatus::OK)
+                msg_type = rnl::Schema<rnl::AckMsg>::type;
+            return _st;
 
-    _tok          = msg.substr(0, msg.find(rnl::DELIM));
-    control       = std::stoi(_tok);
-    msg.erase(0, msg.find(rnl::DELIM) + rnl::DELIM.size()); 
+        case rnl::Schema<rnl::UMsg>::type:
+            _st = rnl::codec::parseBody (staged, data, len);
+            if (_st == rnl::ParseStatus::OK)
+            {
+                static_cast<rnl::UMsg&> (*this) = staged;
+                msg_type = rnl::Schema<rnl::UMsg>::type;
+            }
+            return _st;
 
-    _tok          = msg.substr(0, msg.find(rnl::DELIM));
-    state         = std::stoi(_tok);
-    msg.erase(0, msg.find(rnl::DELIM) + rnl::DELIM.size()); 
+        case '\0':
+            return len ? rnl::ParseStatus::TRUNCATED : rnl::ParseStatus::EMPTY;
 
-    _tok          = msg.substr(0, msg.find(rnl::DELIM));
-    p_id          = std::stoi(_tok);
-    msg.erase(0, msg.find(rnl::DELIM) + rnl::DELIM.size()); 
+        default:
+            return rnl::ParseStatus::BAD_TYPE;
+    }
+}
 
-    _tok          = msg.substr(0, msg.find(rnl::DELIM));
-    neigh_cnt     = std::stoi(_tok);
-    msg.erase(0, msg.find(rnl::DELIM)+  rnl::DELIM.size());
+rnl::Nbt::Nbt ()
+{
+	one_hop = {};
+	two_hop = {};
+}
 
-    _tok          = msg.substr(0, msg.find(rnl::DELIM)); 
-    p_loc.x       = std::stod(_tok.substr(0, _tok.find(rnl::DELIM_POS)));
-    _tok.erase(0, _tok.find(rnl::DELIM_POS) + rnl::DELIM_POS.size());
-    p_loc.y       = std::stod(_tok.substr(0, _tok.find(rnl::DELIM_POS)));
-    _tok.erase(0, _tok.find(rnl::DELIM_POS) + rnl::DELIM_POS.size());
-    p_loc.z       = std::stod(_tok.substr(0, _tok.find(rnl::DELIM_POS)));
-    _tok.erase(0, _tok.find(rnl::DELIM_POS) + rnl::DELIM_POS.size());
-    msg.erase(0, msg.find(rnl::DELIM) + rnl::DELIM.size()); 
+void rnl::Nbt::clear ()
+{
+	clearNb (one_hop, one_hop_seen, one_hop_idx);
+	clearNb (two_hop, two_hop_seen, two_hop_idx);
 }
 
-void rnl::URMsg::parse (std::string& msg)
+size_t rnl::Nbt::expire (double now, double timeout)
 {
-    std::string _tok;
-    _tok          = msg.substr(0, msg.find(rnl::DELIM));
-    msg.erase(0, msg.find(rnl::DELIM) + rnl::DELIM.size()); 
-    if (_tok == "b")
-    {
-        parseBroadcast (msg);
-    }
+	return expireNb (one_hop, one_hop_seen, one_hop_idx, now - timeout)
+	     + expireNb (two_hop, two_hop_seen, two_hop_idx, now - timeout);
+}
 
-    else
-    {
-        parseUnicast (msg);
-    }
+const ns3::Vector3D* rnl::Nbt::findNb (int _id) const
+{
+	return findNbIn (one_hop, one_hop_idx, _id);
 }
 
-rnl::Nbt::Nbt ()
+const ns3::Vector3D* rnl::Nbt::findTwoHopNb (int _id) const
 {
-	one_hop = {};
-	two_hop = {};
+	return findNbIn (two_hop, two_hop_idx, _id);
 }
 
-void rnl::Nbt::serialize (std::string* dst)
+void rnl::Nbt::serialize (std::string* dst, const ns3::Vector3D& origin)
 {
+    if (rnl::WIRE_FORMAT == rnl::WireFormat::BINARY)
+    {
+        int64_t ox = quantize (origin.x);
+        int64_t oy = quantize (origin.y);
+        int64_t oz = quantize (origin.z);
+
+        dst->clear ();
+        rnl::codec::putU8 (dst, rnl::WIRE_MAGIC);
+        putQuantVec (dst, ox, oy, oz);
+        for (const auto* hop : {&one_hop, &two_hop})
+        {
+            rnl::codec::putVarint (dst, hop->size ());
+            for (const auto& n : *hop)
+            {
+                rnl::codec::putVarint (dst, static_cast<uint64_t> (n.first));
+                putQuantVec (dst, quantize (n.second.x) - ox, quantize (n.second.y) - oy, quantize (n.second.z) - oz);
+            }
+        }
+        return;
+    }
+
     std::stringstream f;    
     for (auto n: one_hop)
         f << n.first << rnl::DELIM_NBTID_POS << n.second.x << rnl::DELIM_NBTPOS << n.second.y << rnl::DELIM_NBTPOS << n.second.z << rnl::DELIM_NBTHOP;
@@ -170,39 +242,104 @@ void rnl::Nbt::serialize (std::string* dst)
     *dst = f.str();
 }
 
+rnl::ParseStatus rnl::Nbt::parse (std::string_view src)
+{
+    if (!src.size ())
+        return rnl::ParseStatus::EMPTY;
+    if (static_cast<uint8_t> (src[0]) != rnl::WIRE_MAGIC)
+        return parseText (src);
+
+    rnl::codec::BinReader r {reinterpret_cast<const uint8_t*> (src.data ()), src.size (), 0, true};
+    if (r.u8 () != rnl::WIRE_MAGIC)
+        return rnl::ParseStatus::BAD_TYPE;
+
+    int64_t ox = rnl::codec::unzigzag (r.varint ());
+    int64_t oy = rnl::codec::unzigzag (r.varint ());
+    int64_t oz = rnl::codec::unzigzag (r.varint ());
+
+    clear ();
+    for (int h = 0; h < 2; ++h)
+    {
+        uint64_t _cnt = r.varint ();
+        /* Every entry takes at least 4 bytes, reject counts the frame cannot hold */
+        if (!r.ok || _cnt > (r.len - r.off) / 4)
+            return rnl::ParseStatus::TRUNCATED;
+
+        for (uint64_t k = 0; k < _cnt; ++k)
+        {
+            uint64_t      _id = r.varint ();
+            ns3::Vector3D _pos;
+            _pos.x = (ox + rnl::codec::unzigzag (r.varint ())) * rnl::NBT_QUANT;
+            _pos.y = (oy + rnl::codec::unzigzag (r.varint ())) * rnl::NBT_QUANT;
+            _pos.z = (oz + rnl::codec::unzigzag (r.varint ())) * rnl::NBT_QUANT;
+            if (_id >= static_cast<uint64_t> (rnl::NBT_MAX_ID))
+                return rnl::ParseStatus::BAD_FIELD;
+
+            if (h == 0)
+                updateNb (static_cast<int> (_id), _pos, 0);
+            else
+                updateTwoHopNb (static_cast<int> (_id), _pos, 0);
+        }
+    }
+
+    return r.ok ? rnl::ParseStatus::OK : rnl::ParseStatus::TRUNCATED;
+}
+
+rnl::ParseStatus rnl::Nbt::parseText (std::string_view src)
+{
+    clear ();
+    rnl::codec::TextReader hops {src, 0, true};
+    for (int h = 0; h < 2; ++h)
+    {
+        std::string_view _hop = hops.next (rnl::DELIM_NBTMHOP);
+        if (!hops.ok)
+            return rnl::ParseStatus::TRUNCATED;
+
+        rnl::codec::TextReader r {_hop, 0, true};
+        while (r.off < _hop.size ())
+        {
+            std::string_view _id_tok  = r.next (rnl::DELIM_NBTID_POS);
+            std::string_view _pos_tok = r.next (rnl::DELIM_NBTHOP);
+            if (!r.ok)
+                return rnl::ParseStatus::TRUNCATED;
+
+            rnl::codec::TextReader _p {_pos_tok, 0, true};
+            int           _id;
+            ns3::Vector3D _pos;
+            bool _ok = rnl::codec::toInt (_id_tok, &_id);
+            _ok      = rnl::codec::toDouble (_p.next (rnl::DELIM_NBTPOS), &_pos.x) && _ok;
+            _ok      = rnl::codec::toDouble (_p.next (rnl::DELIM_NBTPOS), &_pos.y) && _ok;
+            _ok      = rnl::codec::toDouble (_p.next (rnl::DELIM_NBTPOS), &_pos.z) && _ok;
+            if (!_ok || !_p.ok || _p.off < _pos_tok.size () || _id < 0 || _id >= rnl::NBT_MAX_ID)
+                return rnl::ParseStatus::BAD_FIELD;
+
+            if (h == 0)
+                updateNb (_id, _pos, 0);
+            else
+                updateTwoHopNb (_id, _pos, 0);
+        }
+    }
+
+    return rnl::ParseStatus::OK;
+}
+
+void rnl::Nbt::updateNb (int _id, const ns3::Vector3D& temp, double now)
+{
+	upsertNb (one_hop, one_hop_seen, one_hop_idx, _id, temp, now);
+}
 
-void rnl::Nbt::parseSingleNb(std::string msg)
-{
-	if (msg.size())
-	{
-		std::string _tok;
-        
-		/*Get BC ID*/
-		_tok = msg.substr (0, msg.find(rnl::DELIM));
-		int _id = std::stoi (_tok);
-		msg.erase(0, msg.find(rnl::DELIM) + rnl::DELIM.size());
-		
-		/*Get Pos*/
-		_tok          = msg.substr(0, msg.find(rnl::DELIM));
-		ns3::Vector3D temp; 
-		temp.x       = std::stod(_tok.substr(0, _tok.find(rnl::DELIM_POS)));
-		_tok.erase(0, _tok.find(rnl::DELIM_POS) + rnl::DELIM_POS.size());
-		temp.y       = std::stod(_tok.substr(0, _tok.find(rnl::DELIM_POS)));
-		_tok.erase(0, _tok.find(rnl::DELIM_POS) + rnl::DELIM_POS.size());
-		temp.z       = std::stod(_tok.substr(0, _tok.find(rnl::DELIM_POS)));
-		_tok.erase(0, _tok.find(rnl::DELIM_POS) + rnl::DELIM_POS.size());
-		msg.erase(0, msg.find(rnl::DELIM) + rnl::DELIM.size());
-		
-		auto it = std::find_if(one_hop.begin(), one_hop.end(),
-		[&_id](const std::pair<int, ns3::Vector3D>& _p){return _p.first  == _id; } ); 
-
-		if (one_hop.size() && it->first == _id)
-		{
-			it->second = temp;
-		}
-		else
-		{
-			one_hop.push_back(std::pair<int, ns3::Vector3D>(_id, temp));
-		}
-	}
+void rnl::Nbt::updateTwoHopNb (int _id, const ns3::Vector3D& temp, double now)
+{
+	upsertNb (two_hop, two_hop_seen, two_hop_idx, _id, temp, now);
+}
+
+std::string rnl::nodeAddress (int id)
+{
+    int host = id + 257;
+    return rnl::IP_BASE + std::to_string (host >> 8) + "." + std::to_string (host & 0xff);
+}
+
+int rnl::nodeIndex (uint32_t ip)
+{
+    return static_cast<int> (ip & 0xffff) - 257;
 }
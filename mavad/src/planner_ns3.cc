@@ -1,46 +1,7 @@
 #include "planner_ns3.h"
 
-#include "ns3/packet-sink.h"
-#include "ns3/packet-sink-helper.h"
-#include "ns3/bulk-send-helper.h"
-
-int start_lawn = 0;
-int start_left = 0;
-int Pkt[] = {1, 1, 1, 1, 1, 1, 1, 1, 1};
-
-
-void TraceSink (std::size_t index, ns3::Ptr<const ns3::Packet> p, const ns3::Address& a)
-{
-  std::cerr << "At " << ns3::Simulator::Now ().GetSeconds ()
-            << " sec, node" << index << " received " << p->GetSize () << "bytes"
-            << " from "<< ns3::InetSocketAddress::ConvertFrom (a).GetIpv4() << std::endl;
-
-  std::ofstream out;
-  std::string fileName = "pkt_rec_time.txt";
-  out.open(fileName.c_str(), std::ios::app);
-  for(int i=0; i<=5; i++){
-    if( ns3::Ipv4Address( (rnl::IP_BASE + std::to_string(i+1)).c_str() ) == ns3::InetSocketAddress::ConvertFrom(a).GetIpv4() )
-    {
-      out << "At " << ns3::Simulator::Now().GetSeconds() << "\t" << "received " << "Pkt No.:" << Pkt[i]
-          << " from "<< "node" << i << std::endl;
-
-      Pkt[i]++;
-
-      if(Pkt[i] == 21)
-      {
-        Pkt[i] = 1;
-        out << std::endl;
-
-        if(i==5)
-        {
-          out << "-------------------------------------------" << std::endl << std::endl;
-        }
-      }
-      break;
-    }
-  }
-  out.close();
-}
+#include <algorithm>
+#include <chrono>
 
 /*---------------------------------------------------------------------------*/
 /*-------------------------------Properties---------------------------------*/
@@ -126,68 +87,47 @@ void rnl::Properties::setInternet()
   internet.SetRoutingHelper (staticRouting); 
   internet.Install (c);
   std::cerr<<"Assigning IP"<<std::endl;
-  std::string bid = rnl::IP_BASE + "0"; 
-  ipv4.SetBase (bid.c_str(), "255.255.255.0");
+  std::string bid = rnl::IP_BASE + "0.0";
+  ipv4.SetBase (bid.c_str(), "255.255.0.0", "0.0.1.1");
   i = ipv4.Assign (devices);
 
-  // nodes:
-    // n2  n5
-    // n0  n3  n6  n7
-    // n1  n4
-
-  // [n2 to n7], [n0 to n7], [n3 to n7]
-  SetStaticRoute(c.Get(2),  (rnl::IP_BASE + "8").c_str(), (rnl::IP_BASE + "1").c_str(), 1);
-  SetStaticRoute(c.Get(0),  (rnl::IP_BASE + "8").c_str(), (rnl::IP_BASE + "4").c_str(), 1);
-  SetStaticRoute(c.Get(3),  (rnl::IP_BASE + "8").c_str(), (rnl::IP_BASE + "7").c_str(), 1);
-  SetStaticRoute(c.Get(6),  (rnl::IP_BASE + "8").c_str(), (rnl::IP_BASE + "8").c_str(), 1);
-
-  // [n7 to n2]
-  SetStaticRoute(c.Get(7),  (rnl::IP_BASE + "3").c_str(), (rnl::IP_BASE + "7").c_str(), 1);
-  SetStaticRoute(c.Get(6),  (rnl::IP_BASE + "3").c_str(), (rnl::IP_BASE + "4").c_str(), 1);
-  SetStaticRoute(c.Get(3),  (rnl::IP_BASE + "3").c_str(), (rnl::IP_BASE + "1").c_str(), 1);
-  SetStaticRoute(c.Get(0),  (rnl::IP_BASE + "3").c_str(), (rnl::IP_BASE + "3").c_str(), 1);
-
-  // [n7 to n0]
-  SetStaticRoute(c.Get(7),  (rnl::IP_BASE + "1").c_str(), (rnl::IP_BASE + "7").c_str(), 1);
-  SetStaticRoute(c.Get(6),  (rnl::IP_BASE + "1").c_str(), (rnl::IP_BASE + "4").c_str(), 1);
-  SetStaticRoute(c.Get(3),  (rnl::IP_BASE + "1").c_str(), (rnl::IP_BASE + "1").c_str(), 1);
-
-  // [n7 to n3]
-  SetStaticRoute(c.Get(7),  (rnl::IP_BASE + "4").c_str(), (rnl::IP_BASE + "7").c_str(), 1);
-  SetStaticRoute(c.Get(6),  (rnl::IP_BASE + "4").c_str(), (rnl::IP_BASE + "4").c_str(), 1);
-
-  // [n1 to n7]
-  SetStaticRoute(c.Get(1), (rnl::IP_BASE + "8").c_str(), (rnl::IP_BASE + "1").c_str(), 1);
-
-  // [n7 to n1]
-  SetStaticRoute(c.Get(7),  (rnl::IP_BASE + "2").c_str(), (rnl::IP_BASE + "7").c_str(), 1);
-  SetStaticRoute(c.Get(6),  (rnl::IP_BASE + "2").c_str(), (rnl::IP_BASE + "4").c_str(), 1);
-  SetStaticRoute(c.Get(3),  (rnl::IP_BASE + "2").c_str(), (rnl::IP_BASE + "1").c_str(), 1);
-  SetStaticRoute(c.Get(0),  (rnl::IP_BASE + "2").c_str(), (rnl::IP_BASE + "2").c_str(), 1);
-
-  // [n5 to n7]
-  SetStaticRoute(c.Get(5), (rnl::IP_BASE + "8").c_str(), (rnl::IP_BASE + "4").c_str(), 1);
-
-  // [n7 to n5]
-  SetStaticRoute(c.Get(7),  (rnl::IP_BASE + "6").c_str(), (rnl::IP_BASE + "7").c_str(), 1);
-  SetStaticRoute(c.Get(6),  (rnl::IP_BASE + "6").c_str(), (rnl::IP_BASE + "4").c_str(), 1);
-  SetStaticRoute(c.Get(3),  (rnl::IP_BASE + "6").c_str(), (rnl::IP_BASE + "6").c_str(), 1);
-
-  // [n4 to n7]
-  SetStaticRoute(c.Get(4), (rnl::IP_BASE + "8").c_str(), (rnl::IP_BASE + "4").c_str(), 1);
-
-  // [n7 to n4]
-  SetStaticRoute(c.Get(7),  (rnl::IP_BASE + "5").c_str(), (rnl::IP_BASE + "7").c_str(), 1);
-  SetStaticRoute(c.Get(6),  (rnl::IP_BASE + "5").c_str(), (rnl::IP_BASE + "4").c_str(), 1);
-  SetStaticRoute(c.Get(3),  (rnl::IP_BASE + "5").c_str(), (rnl::IP_BASE + "5").c_str(), 1);
-
-  std::string fName = "pkt_rec_time.txt";
-  std::ofstream fout (fName.c_str());
-  fout.close();
+  for (uint32_t k = 0; k < c.GetN (); ++k)
+  {
+    SetMulticastRoute (c.Get(k), 1);
+  }
 
   std::cerr<<"IPs Assigned"<<std::endl;
 }
 
+void rnl::Properties::setRoutes (const rnl::Formation& f)
+{
+  /* Every node reaches the base along the relay tree of the formation, and every node
+     on the way back from the base knows the hop towards it */
+  int base = f.baseId ();
+  for (int d = 0; d < base && d < static_cast<int> (c.GetN ()); ++d)
+  {
+    int hop = f.towardBase (d);
+    SetStaticRoute (c.Get(d), rnl::nodeAddress (base).c_str(), rnl::nodeAddress (hop).c_str(), 1);
+    for (int prev = d, at = hop; at >= 0; prev = at, at = f.towardBase (at))
+    {
+      SetStaticRoute (c.Get(at), rnl::nodeAddress (d).c_str(), rnl::nodeAddress (prev).c_str(), 1);
+    }
+  }
+  std::cerr << "Static routes set for " << base << " drones" << std::endl;
+}
+
+void rnl::Properties::SetMulticastRoute(ns3::Ptr<ns3::Node> n, uint32_t interface)
+{
+  ns3::Ipv4StaticRoutingHelper staticRouting;
+  ns3::Ptr<ns3::Ipv4> ipv4 = n->GetObject<ns3::Ipv4> ();
+  staticRouting.GetStaticRouting (ipv4)->SetDefaultMulticastRoute (interface);
+}
+
+void rnl::Properties::JoinGroup(ns3::Ptr<ns3::Node> n, const std::string& group)
+{
+  n->GetObject<ns3::Ipv4L3Protocol> ()->AddMulticastAddress (ns3::Ipv4Address (group.c_str()));
+}
+
 void rnl::Properties::SetStaticRoute(ns3::Ptr<ns3::Node> n, const char* destination, const char* nextHop, uint32_t interface)
 {
   ns3::Ipv4StaticRoutingHelper staticRouting;
@@ -209,35 +149,58 @@ ns3::TypeId rnl::Properties::tid_val () const
 /*---------------------------------------------------------------------------*/
 /*-------------------------------DroneSoc---------------------------------*/
 /*---------------------------------------------------------------------------*/
-rnl::DroneSoc::DroneSoc()
+rnl::DroneSoc::DroneSoc(): rate{rnl::RATE_MAX_SKIP, rnl::RATE_BUSY_HI}
 {
   source = nullptr;
   recv_sink = nullptr;
+  dirty = false;
+  dirty_queue = nullptr;
+  slots = nullptr;
+  last_state = -998;
+  last_control = -998;
+  ctrl_counter = 0;
+  ctrl_cmd = 0;
+  ctrl_soc = nullptr;
+  ctrl_active = false;
+  ctrl_pending = {0, 0, 0, -1, 0};
+  hot = nullptr;
+  path_gen = 0;
+  scan_gen = 0;
+  sending = false;
+  beaconing = false;
 }
 
 void rnl::DroneSoc::closeSender ()
 {
-  this->source -> Close();
+  for (auto& _entry : sender_cache)
+  {
+    _entry.second->Close();
+  }
+  sender_cache.clear ();
+  this->source = nullptr;
 }
 
 void rnl::DroneSoc::setSender (ns3::Ptr<ns3::Node> node, ns3::TypeId tid, const std::string& ip)
 {
-  this->source = ns3::Socket::CreateSocket (node, tid);
-  ns3::InetSocketAddress remote1 = ns3::InetSocketAddress (ns3::Ipv4Address (ip.c_str()), 9);
-  std::cerr << "setSender IP to IP: " << (rnl::IP_BASE).c_str() << this->id + 1 << ", "<< ip.c_str() <<std::endl;
-  this->source->Connect (remote1);
+  this->udp_tid = tid;
+  this->source  = senderFor (node, tid, ip);
 }
 
-void rnl::DroneSoc::setSenderTCP (ns3::Ptr<ns3::Node> node, const std::string& self_ip, const std::string& remote_ip, ns3::Time startTime)
+ns3::Ptr<ns3::Socket> rnl::DroneSoc::senderFor (ns3::Ptr<ns3::Node> node, ns3::TypeId tid, const std::string& ip)
 {
-  ns3::BulkSendHelper source ("ns3::TcpSocketFactory", ns3::InetSocketAddress (self_ip.c_str(), 8080));
-  source.SetAttribute ("MaxBytes", ns3::UintegerValue (536*20));
-  ns3::InetSocketAddress remote = ns3::InetSocketAddress (ns3::Ipv4Address ( remote_ip.c_str() ), 8080);
-  source.SetAttribute ("Remote", ns3::AddressValue (remote));
-  source.SetAttribute ("SendSize", ns3::UintegerValue (536));
-  ns3::ApplicationContainer sourceApps = source.Install (node);
-  sourceApps.Start (startTime);
-  sourceApps.Stop (startTime + ns3::Seconds (1));
+  ns3::Ipv4Address _dst (ip.c_str());
+  auto it = sender_cache.find (_dst.Get ());
+  if (it != sender_cache.end ())
+  {
+    return it->second;
+  }
+
+  ns3::Ptr<ns3::Socket> _soc = ns3::Socket::CreateSocket (node, tid);
+  ns3::InetSocketAddress remote1 = ns3::InetSocketAddress (_dst, 9);
+  std::cerr << "setSender IP to IP: " << rnl::nodeAddress (this->id) << ", "<< ip.c_str() <<std::endl;
+  _soc->Connect (remote1);
+  sender_cache.emplace (_dst.Get (), _soc);
+  return _soc;
 }
 
 void rnl::DroneSoc::setBcSender (ns3::Ptr<ns3::Node> node, ns3::TypeId tid)
@@ -256,63 +219,143 @@ void rnl::DroneSoc::setRecv (ns3::Ptr<ns3::Node> node, ns3::TypeId tid)
   this -> recv_sink->SetRecvCallback (ns3::MakeCallback (&rnl::DroneSoc::receivePacket, this));
 }
 
-void rnl::DroneSoc::setRecvTCP (ns3::Ptr<ns3::Node> node, const std::string& ip, int num_nodes, ns3::Time stopTime)
+void rnl::DroneSoc::receivePacket(ns3::Ptr<ns3::Socket> soc)
 {
-  ns3::Address sinkAddress (ns3::InetSocketAddress (ip.c_str(), 8080));
-  ns3::PacketSinkHelper packetSinkHelper ("ns3::TcpSocketFactory", ns3::InetSocketAddress (ns3::Ipv4Address::GetAny (), 8080));
-  ns3::ApplicationContainer sinkApps = packetSinkHelper.Install (node);
-  ns3::Ptr<ns3::PacketSink> packetSink = sinkApps.Get (0)->GetObject<ns3::PacketSink> ();
-  packetSink->TraceConnectWithoutContext ("Rx", ns3::MakeBoundCallback (&TraceSink, num_nodes-1));
-  sinkApps.Start (ns3::Seconds (80));
-  sinkApps.Stop (stopTime);
+  rnl::BufferPool::Lease buf = rx_pool.acquire ();
+
+  while (ns3::Ptr<ns3::Packet> msg = soc->Recv ())
+  {
+    buf->resize (msg->GetSize ());
+    msg->CopyData (reinterpret_cast<uint8_t*> (&(*buf)[0]), msg->GetSize ());
+    handleFrame (buf.data (), buf->size ());
+  }
 }
 
-void rnl::DroneSoc::receivePacket(ns3::Ptr<ns3::Socket> soc)
+void rnl::DroneSoc::handleFrame (const uint8_t* data, size_t len)
 {
-  std::string receivedData;
-  
-  while (ns3::Ptr<ns3::Packet> msg = soc->Recv ())
+  double           _now = ns3::Simulator::Now ().GetSeconds ();
+  rnl::ParseStatus _st  = msg_rec.parse (data, len);
+  if (_st != rnl::ParseStatus::OK)
   {
-    uint8_t *buffer = new uint8_t[msg->GetSize ()];
-    msg->CopyData (buffer, msg->GetSize ());
-    receivedData = std::string ((char *) buffer);
+    std::cerr << this->id << " dropped malformed packet, status " << static_cast<int> (_st) << std::endl;
+    return;
   }
-  msg_rec.parse(receivedData);
-  nbt.parseSingleNb (this->msg_rec.bc_nbs);
-} 
+  if (msg_rec.msg_type == 'a')
+  {
+    if (ctrl_active && msg_rec.ack.seq == ctrl_pending.seq)
+    {
+      finishControl (true);
+    }
+    return;
+  }
+  markDirty ();
+  if (msg_rec.msg_type == 'u' && msg_rec.ctrl_seq > 0)
+  {
+    sendAck (msg_rec.source_id, msg_rec.ctrl_seq);
+  }
+  if (msg_rec.msg_type == 'u' && circle_cache.valid
+      && ns3::CalculateDistance (msg_rec.p_loc, circle_cache.anchor) > rnl::CIRCLE_TOL)
+  {
+    /* The parent moved, the cached path to its circle range is stale */
+    circle_cache.valid = false;
+  }
+  if (msg_rec.msg_type == 'b')
+  {
+    nbt.updateNb (msg_rec.bc.id, msg_rec.bc.pos, _now);
+  }
+  else if (peer_nbt.parse (msg_rec.nbs) == rnl::ParseStatus::OK)
+  {
+    /* One hop neighbours of the sender are two hop neighbours of this drone */
+    for (const auto& n : peer_nbt.one_hop)
+    {
+      if (n.first != this->id)
+      {
+        nbt.updateTwoHopNb (n.first, n.second, _now);
+      }
+    }
+  }
+}
 
 void rnl::DroneSoc::updateSendMsg ()
 {
   if (msg_send.p_id == this->id)
   {
-    msg_send.p_loc = this->pos;
+    msg_send.p_loc = this->pos ();
   }
 }
 
 void rnl::DroneSoc::sendBcPacket (ns3::Time pktInterval, int n)
 {
-  std::string msg;
-  msg_send.serializeBC(&msg, this->id, this->pos);
-	ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet> ((uint8_t*) msg.c_str(), msg.length());
-	
-  this->source_bc->Send (packet);  
+  if (slots && !slots->isMember (this->id))
+  {
+    beaconing = false;
+    return;
+  }
+  if (!slots || toggle_bc ==1)
+  {
+    rnl::BufferPool::Lease msg = tx_pool.acquire ();
+    msg_send.serializeBC (msg.get (), this->id, this->pos ());
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet> (msg.data (), msg->size ());
+
+    this->source_bc->Send (packet);
+  }
+
+  if (slots)
+  {
+    /* Beacons keep the base frame rate whatever the backoff of the unicasts */
+    ns3::Time _now = ns3::Simulator::Now ();
+    ns3::Simulator::Schedule (slots->nextBroadcast (this->id, _now) - _now, &rnl::DroneSoc::sendBcPacket, this,
+    pktInterval, n);
+  }
 }
 
 void rnl::DroneSoc::sendPacket (ns3::Time pktInterval, int n)
 {
+  if (slots && !slots->isMember (this->id))
+  {
+    std::cerr << this->id << " left the TDMA schedule, stops sending" << std::endl;
+    sending = false;
+    return;
+  }
+  frame_len = slots ? slots->frameLength () : n * pktInterval;
   updateSendMsg ();
-  std::string msg;
-  msg_send.serialize(&msg);
-	ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet> ((uint8_t*) msg.c_str(), msg.length());
+  trackControl ();
+  /* Never drop a neighbour that is only backing off */
+  nbt.expire (ns3::Simulator::Now ().GetSeconds (),
+              std::max (rnl::NBT_TIMEOUT, 2 * rnl::RATE_MAX_SKIP * frame_len.GetSeconds ()));
+  nbt.serialize (&msg_send.nbs, this->pos ());
+  rnl::BufferPool::Lease msg = tx_pool.acquire ();
+  msg_send.serialize (msg.get ());
+	ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet> (msg.data (), msg->size ());
 	
   this->source->Send (packet);
-  if (toggle_bc ==1)
+
+  ns3::Time _now     = ns3::Simulator::Now ();
+  last_send = _now;
+  bool      _changed = msg_send.state != last_state || msg_send.control != last_control;
+  last_state   = msg_send.state;
+  last_control = msg_send.control;
+  int       _k       = rate.next (isManoeuvring (), _changed, _now.GetSeconds ());
+
+  if (slots)
   {
-    ns3::Simulator::Schedule ((n - 1/2)*pktInterval, &rnl::DroneSoc::sendBcPacket, this,
+    /* The beacons run their own loop in the broadcast half @see sendBcPacket */
+    ns3::Time _after = _now + (_k - 1) * slots->frameLength ();
+    next_send = slots->nextUnicast (this->id, _after);
+    ns3::Simulator::Schedule (next_send - _now, &rnl::DroneSoc::sendPacket, this,
+    pktInterval, n);
+  }
+  else
+  {
+    if (toggle_bc ==1)
+    {
+      ns3::Simulator::Schedule ((n - 0.5)*pktInterval, &rnl::DroneSoc::sendBcPacket, this,
+      pktInterval, n);
+    }
+    next_send = _now + _k*n*pktInterval;
+    ns3::Simulator::Schedule (_k*n*pktInterval, &rnl::DroneSoc::sendPacket, this,
     pktInterval, n);
   }
-	ns3::Simulator::Schedule (n*pktInterval, &rnl::DroneSoc::sendPacket, this,
-	pktInterval, n);
 
   std::cerr << this->id << " sendPacket with state and control: "<< this->msg_send.state << ", "<< this->msg_send.control << std::endl;
 }
@@ -328,18 +371,182 @@ void rnl::DroneSoc::initializeRosParams (ros::NodeHandle& nh)
 
 void rnl::DroneSoc::posSubCb (const geometry_msgs::PoseStamped& _pos)
 {
-  this->pos.x = _pos.pose.position.x;
-  this->pos.y = _pos.pose.position.y;
-  this->pos.z = _pos.pose.position.z;
+  setPos (ns3::Vector3D (_pos.pose.position.x, _pos.pose.position.y, _pos.pose.position.z));
+
+  if (ns3::CalculateDistance (pos (), this->eval_pos) > rnl::DIRTY_DIST)
+  {
+    markDirty ();
+  }
+}
+
+void rnl::DroneSoc::trackControl ()
+{
+  int _cmd = msg_send.control & rnl::CTRL_RELIABLE;
+  if (_cmd != ctrl_cmd || source != ctrl_soc)
+  {
+    if (ctrl_active)
+    {
+      finishControl (false);
+    }
+    ctrl_cmd = _cmd;
+    ctrl_soc = source;
+    if (_cmd)
+    {
+      ctrl_pending = {++ctrl_counter, _cmd, ns3::Simulator::Now ().GetSeconds (), -1, 0};
+      ctrl_active  = true;
+      ns3::Simulator::Schedule (retransmitTime () - ns3::Simulator::Now (), &rnl::DroneSoc::retransmitControl, this, ctrl_pending.seq);
+    }
+  }
+  msg_send.ctrl_seq = ctrl_active ? ctrl_pending.seq : 0;
+}
+
+void rnl::DroneSoc::retransmitControl (int seq)
+{
+  if (!ctrl_active || ctrl_pending.seq != seq)
+  {
+    return;
+  }
+  if ((msg_send.control & rnl::CTRL_RELIABLE) != ctrl_cmd || source != ctrl_soc)
+  {
+    /* Superseded, the next sendPacket opens the new command */
+    return;
+  }
+  if (ctrl_pending.retries >= rnl::CTRL_RTX_MAX)
+  {
+    std::cerr << this->id << " gave up control " << ctrl_cmd << " seq " << seq << std::endl;
+    finishControl (false);
+    msg_send.ctrl_seq = 0;
+    return;
+  }
+
+  ctrl_pending.retries++;
+  msg_send.ctrl_seq = seq;
+  ns3::Time _now = ns3::Simulator::Now ();
+  if (_now != last_send && _now != next_send)
+  {
+    rnl::BufferPool::Lease msg = tx_pool.acquire ();
+    msg_send.serialize (msg.get ());
+    ctrl_soc->Send (ns3::Create<ns3::Packet> (msg.data (), msg->size ()));
+  }
+  ns3::Simulator::Schedule (retransmitTime () - _now, &rnl::DroneSoc::retransmitControl, this, seq);
+}
+
+ns3::Time rnl::DroneSoc::retransmitTime () const
+{
+  ns3::Time _now = ns3::Simulator::Now ();
+  if (slots && slots->isMember (this->id))
+  {
+    return slots->nextUnicast (this->id, _now + (rnl::CTRL_RTX_FRAMES - 1) * slots->frameLength ());
+  }
+  return _now + rnl::CTRL_RTX_FRAMES * frame_len;
+}
+
+void rnl::DroneSoc::finishControl (bool acked)
+{
+  if (acked)
+  {
+    ctrl_pending.latency = ns3::Simulator::Now ().GetSeconds () - ctrl_pending.sent;
+  }
+  ctrl_log.push_back (ctrl_pending);
+  ctrl_active = false;
+}
+
+void rnl::DroneSoc::sendAck (int to, int seq)
+{
+  if (!slots || !slots->isMember (this->id))
+  {
+    ack_queue.push_back ({to, seq});
+    flushAcks ();
+    return;
+  }
+  if (ack_queue.empty ())
+  {
+    ns3::Time _now = ns3::Simulator::Now ();
+    ns3::Simulator::Schedule (slots->nextUnicast (this->id, _now) - _now, &rnl::DroneSoc::flushAcks, this);
+  }
+  ack_queue.push_back ({to, seq});
+}
+
+void rnl::DroneSoc::flushAcks ()
+{
+  for (const std::pair<int, int>& _ack : ack_queue)
+  {
+    ns3::Ptr<ns3::Socket> _soc = senderFor (recv_sink->GetNode (), udp_tid, rnl::nodeAddress (_ack.first));
+    rnl::BufferPool::Lease msg = tx_pool.acquire ();
+    msg_send.serializeAck (msg.get (), this->id, _ack.second);
+    _soc->Send (ns3::Create<ns3::Packet> (msg.data (), msg->size ()));
+  }
+  ack_queue.clear ();
+}
+
+bool rnl::DroneSoc::isManoeuvring () const
+{
+  if (hot->state[id] & (SANCHORING | SCHANGEPAR))
+  {
+    return true;
+  }
+  return !(hot->state[id] & SLAWNMOVERING) && hot->la_len[id] - lookAheadDist () >= rnl::RATE_LONG_DIST;
+}
+
+void rnl::DroneSoc::phyStateCb (ns3::Time /*start*/, ns3::Time duration, ns3::WifiPhyState state)
+{
+  if (state == ns3::WifiPhyState::RX || state == ns3::WifiPhyState::TX || state == ns3::WifiPhyState::CCA_BUSY)
+  {
+    rate.addBusy (duration.GetSeconds ());
+  }
+}
+
+void rnl::DroneSoc::markDirty ()
+{
+  if (dirty)
+  {
+    return;
+  }
+  dirty = true;
+  if (dirty_queue)
+  {
+    dirty_queue->push_back (this->id);
+  }
+}
+
+ns3::Vector3D rnl::DroneSoc::pos () const
+{
+  return hot->position (this->id);
+}
+
+void rnl::DroneSoc::setPos (const ns3::Vector3D& p)
+{
+  hot->setPosition (this->id, p);
+}
 
+double rnl::DroneSoc::lookAheadDist () const
+{
+  return hot->la_s[this->id];
+}
+
+void rnl::DroneSoc::setLookAhead (double s)
+{
+  hot->setLookAhead (this->id, s, traj);
+}
+
+void rnl::DroneSoc::startPath ()
+{
+  ++path_gen;
+  setLookAhead (traj.advance (0, rnl::STEP));
+}
+
+void rnl::DroneSoc::syncState ()
+{
+  hot->setState (this->id, msg_send.state, msg_send.control, msg_send.p_id);
 }
 
 void rnl::DroneSoc::publishLookAhead ()
 {
   geometry_msgs::Pose _lka;
-  _lka.position.x = this->wpts[this->lookaheadindex].x;
-  _lka.position.y = this->wpts[this->lookaheadindex].y;
-  _lka.position.z = this->wpts[this->lookaheadindex].z;
+  ns3::Vector3D _w = hot->lookAhead (this->id);
+  _lka.position.x = _w.x;
+  _lka.position.y = _w.y;
+  _lka.position.z = _w.z;
   
   drone_lk_ahead_pub.publish (_lka);
 }
@@ -351,12 +558,19 @@ rnl::Planner::Planner(ros::NodeHandle& _nh, ros::NodeHandle& _nh_private, rnl::P
               float _pos_int, float _stopTime):
 wifi_prop{p}, num_nodes{n}, pkt_interval{ns3::Seconds(_pki)},
 pos_interval{ns3::Seconds(_pos_int)}, stopTime{ns3::Seconds(_stopTime)},
-nh{_nh}, nh_private{_nh_private}
+nh{_nh}, nh_private{_nh_private},
+slots{ns3::Seconds(_pki), ns3::Seconds(_pki * rnl::SLOT_GUARD), 2 * rnl::COMM_RANGE}
 {
   leader_id = 0;
   ldirec_flag = 1;
   lchild_id = 1;
-  tail_id = 6;
+  formation = rnl::Formation (rnl::Formation::Shape::T, num_nodes);
+  grid = rnl::SpatialGrid (rnl::RC);
+  event_driven = false;
+  scan_scheduled = false;
+  drop_id = -1;
+  flow_interval = ns3::Seconds (0);
+  coverage.setWidth (rnl::SWEEP_WIDTH);
 }
 
 void rnl::Planner::initializeMobility ()
@@ -364,7 +578,7 @@ void rnl::Planner::initializeMobility ()
   ns3::Ptr<ns3::ListPositionAllocator> positionAlloc = ns3::CreateObject<ns3::ListPositionAllocator> ();
 
   for (int i = 0; i< num_nodes; ++i){
-    positionAlloc -> Add (nsocs[i].pos);
+    positionAlloc -> Add (nsocs[i].pos ());
   }
   mobility.SetPositionAllocator (positionAlloc);
   mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
@@ -415,6 +629,8 @@ rnl::USMsg rnl::setinitialSMsg (rnl::Nbt nbt, int id, int n)
 void rnl::Planner::initializeSockets ()
 {
   nsocs.clear();
+  hot.resize (num_nodes);
+  grid.clear ();
   for (int i = 0 ; i < num_nodes; ++i)
   {
     rnl::DroneSoc  _dsoc;
@@ -424,474 +640,556 @@ void rnl::Planner::initializeSockets ()
     rnl::URMsg     _rmsg;
     if (i+1 < num_nodes)
     {
-      _dsoc.setSender (wifi_prop.c.Get(i), wifi_prop.tid_val(), rnl::IP_BASE + std::to_string(i+2));
+      _dsoc.setSender (wifi_prop.c.Get(i), wifi_prop.tid_val(), rnl::nodeAddress (i+1));
     }
     else
     {
-      _dsoc.setSender (wifi_prop.c.Get(i), wifi_prop.tid_val(), rnl::IP_BASE + std::to_string(rnl::BASEID));
+      _dsoc.setSender (wifi_prop.c.Get(i), wifi_prop.tid_val(), rnl::nodeAddress (rnl::BASEID-1));
     }
     _dsoc.setBcSender (wifi_prop.c.Get(i), wifi_prop.tid_val());
     _dsoc.toggle_bc = 0;
-    _dsoc.pos      = ns3::Vector3D(-i , 0.0 , rnl::Planner::disas_centre.z);
-    rnl::posHold(&_dsoc.wpts,_dsoc.pos);
-    _dsoc.lookaheadindex = 0;
+    _dsoc.hot      = &hot;
+    _dsoc.setPos (ns3::Vector3D(-i , 0.0 , rnl::Planner::disas_centre.z));
+    grid.update (i, _dsoc.pos ());
+    rnl::posHold(&_dsoc.traj,_dsoc.pos ());
+    _dsoc.startPath ();
     _dsoc.msg_send = _smsg;
     _dsoc.msg_rec  = _rmsg;
     _dsoc.nbt      = _nbt;
-    nsocs.push_back(_dsoc);
-  }
-}
-
-bool rnl::Planner::siteReached (ns3::Vector3D pos, int ID)
-{
-  bool res;
-
-  ns3::Vector3D pos0(disas_centre.x + rnl::RC, disas_centre.y,              disas_centre.z);
-  ns3::Vector3D pos1(disas_centre.x + rnl::RC, disas_centre.y + rnl::RC,    disas_centre.z);
-  ns3::Vector3D pos2(disas_centre.x + rnl::RC, disas_centre.y - rnl::RC,    disas_centre.z);
-  ns3::Vector3D pos3(disas_centre.x,           disas_centre.y,              disas_centre.z);
-  ns3::Vector3D pos4(disas_centre.x,           disas_centre.y + rnl::RC,    disas_centre.z);
-  ns3::Vector3D pos5(disas_centre.x,           disas_centre.y - rnl::RC,    disas_centre.z);
-
-	switch(ID)
-	{
-		case 0:
-			res = (ns3::CalculateDistance(pos, pos0) < 0.4) ? 1 : 0;
-			break;
-		case 1:
-			res = (ns3::CalculateDistance(pos, pos1) < 0.8) ? 1 : 0;
-			break;
-		case 2:
-			res = (ns3::CalculateDistance(pos, pos2) < 0.6) ? 1 : 0;
-			break;
-		case 3:
-			res = (ns3::CalculateDistance(pos, pos3) < 0.5) ? 1 : 0;
-			break;
-		case 4:
-			res = (ns3::CalculateDistance(pos, pos4) < 1) ? 1 : 0;
-			break;
-		case 5:
-			res = (ns3::CalculateDistance(pos, pos5) < 0.6) ? 1 : 0;
-			break;
-    default:
-      res = 0;
-      break;
-	}
+    _dsoc.syncState ();
+    nsocs.push_back(std::move(_dsoc));
+  }
+  wifi_prop.setRoutes (formation);
+  joinClusterGroups ();
+}
 
-	return res;
+bool rnl::Planner::siteReached (ns3::Vector3D pos, int ID) const
+{
+  return formation.siteReached (pos, ID, disas_centre);
 }
 
 void rnl::Planner::setLeaderExplorePath ()
 {
-  ns3::Vector3D pos0(disas_centre.x + rnl::RC, disas_centre.y, disas_centre.z);
-  bool res = rnl::getTrajectory (&nsocs[0].wpts, nsocs[0].pos, pos0, rnl::STEP);
-  nsocs[0].lookaheadindex = 0;
-  std::cerr << nsocs[0].pos << " is init pos at "<<ns3::Simulator::Now ().GetSeconds() << std::endl;
+  ns3::Vector3D pos0 = formation.slotPos (0, disas_centre);
+  bool res = rnl::getTrajectory (&nsocs[0].traj, nsocs[0].pos (), pos0);
+  nsocs[0].startPath ();
+  nsocs[0].markDirty ();
+  std::cerr << nsocs[0].pos () << " is init pos at "<<ns3::Simulator::Now ().GetSeconds() << std::endl;
 }
 
 void rnl::Planner::updateStateofCentre ()
 {
-  for(int i=0; i < tail_id; i = i+3)
+  for (int i : formation.centres ())
   {
-    rnl::DroneSoc* unode = &nsocs[i];
-    if (siteReached (unode->pos, unode->id))
-    {
-      if (!(unode->msg_send.state & SSITEREACHED))
-      {
-        unode->msg_send.neigh_cnt = 1;
-        std::cerr << "Centre Site Reached First time" <<std::endl;
-        if(i==0)
-        {
-          unode->msg_rec.state = SGDRONEREQ;
-        }
-
-        start_left = 0;
-      }
-      
-      if(unode->msg_send.neigh_cnt < 4 && siteReached (nsocs[i+unode->msg_send.neigh_cnt].pos, i+unode->msg_send.neigh_cnt))
-      {
-        if(i+unode->msg_send.neigh_cnt < tail_id){
-          unode->msg_send.neigh_cnt++;
-        }
-      }
-      if(unode->msg_send.neigh_cnt < 4)
-      {
-        unode->msg_send.state = (SCENTRE | SSITEREACHED) | SGSITEREACHED;
-        if(i+unode->msg_send.neigh_cnt == tail_id){
-          unode->msg_send.state |= !SGDRONEREQ;
-        }
-        else{
-          unode->msg_send.state |= SGDRONEREQ;
-        }
-        rnl::posHold (&unode->wpts, unode->pos);
-        unode->lookaheadindex = 0;
-        unode->toggle_bc = 1;
-        if(unode->msg_send.neigh_cnt==1)
-        {
-          if(start_left > 20)
-          {
-            unode->msg_send.control = CLTOP;
-          }
-          start_left++;
-        }
-        else if(unode->msg_send.neigh_cnt==2)
-        {
-          unode->msg_send.control = CRTOP;
-        }
-        else if(unode->msg_send.neigh_cnt==3)
-        {
-          unode->msg_send.control = CBTOP;
-        }
+    updateCentre (i);
+  }
+}
 
-        if(!(unode->msg_send.state & SGDRONEREQ))
-        {
-          unode->msg_send.state = SCENTRE | SSITEREACHED | SGSITEREACHED;
-          unode->msg_send.control = 0;
-
-          unode->msg_rec.state &= ~SGDRONEREQ;
-
-          ns3::Simulator::Schedule (pkt_interval, &rnl::DroneSoc::setSender, unode, unode->source->GetNode(),
-                                          wifi_prop.tid_val(), rnl::IP_BASE + std::to_string(i-2));
-          ns3::Simulator::Schedule (2*pkt_interval, &rnl::DroneSoc::setSender, unode, unode->source->GetNode(),
-                                          wifi_prop.tid_val(), rnl::IP_BASE + std::to_string(i+2));
-          ns3::Simulator::Schedule (3*pkt_interval, &rnl::DroneSoc::setSender, unode, unode->source->GetNode(),
-                                          wifi_prop.tid_val(), rnl::IP_BASE + std::to_string(i+3));
-          ns3::Simulator::Schedule (4*pkt_interval, &rnl::DroneSoc::setSender, unode, unode->source->GetNode(),
-                                          wifi_prop.tid_val(), rnl::IP_BASE + std::to_string(i+4));
-
-          if(start_lawn == 50)
-          {
-            for(int ii=1; ii<tail_id; ii++)
-            {
-              if(ii%3>0)
-              {
-                rnl::DroneSoc* unode = &nsocs[ii];
-                ns3::Simulator::Schedule (ns3::Seconds (2.0), &rnl::Planner::doLawnMoverScanning, this, ns3::Seconds (220.0), ii, unode->pos);
-              }
-            }
-          }
-          if(start_lawn < 80)
-          {
-            start_lawn++;
-          }
-        }
-        else
-        {
-          ns3::Simulator::ScheduleNow (&rnl::DroneSoc::setSender, unode, unode->source->GetNode(),
-                                          wifi_prop.tid_val(), rnl::IP_BASE + std::to_string(i+unode->msg_send.neigh_cnt+1));
-        }
-        std::cerr << i << " scheduled pkt with state and control: " << unode->msg_send.state << ", " << unode->msg_send.control << std::endl;
-      }
-      else
-      {
-        if(!(unode->msg_rec.state & SGDRONEREQ))
-        {
-          rnl::posHold (&unode->wpts, unode->pos);
-          unode->lookaheadindex = 0;
-          unode->toggle_bc = 1;
+void rnl::Planner::updateCentre (int i)
+{
+  rnl::DroneSoc* unode = &nsocs[i];
+  if (!siteReached (unode->pos (), unode->id))
+  {
+    unode->syncState ();
+    return;
+  }
 
-          unode->msg_send.state = SCENTRE | SSITEREACHED | SGSITEREACHED;
-          unode->msg_send.control = 0;
+  rnl::PlanEffects _fx;
+  if (!(unode->msg_send.state & SSITEREACHED))
+  {
+    dispatch (i, rnl::FsmEvent::CENTRE_ARRIVED, &_fx);
+  }
 
-          unode->msg_rec.state &= ~SGDRONEREQ;
+  /* kids[neigh_cnt-1] is the child being recruited, it counts once it reaches its slot */
+  const std::vector<int>& kids = formation.children (i);
+  int  n_kids = static_cast<int> (kids.size ());
+  if(unode->msg_send.neigh_cnt <= n_kids && siteReached (nsocs[kids[unode->msg_send.neigh_cnt-1]].pos (), kids[unode->msg_send.neigh_cnt-1]))
+  {
+    unode->msg_send.neigh_cnt++;
+  }
 
-          if(i-2>0)
-          {
-            ns3::Simulator::ScheduleNow (&rnl::DroneSoc::setSender, unode, unode->source->GetNode(),
-                                            wifi_prop.tid_val(), rnl::IP_BASE + std::to_string(i-2));
-          }
+  /* The last centre stays here once its cluster is complete, the others go on relaying */
+  rnl::FsmEvent _event = unode->msg_send.neigh_cnt <= n_kids       ? rnl::FsmEvent::KID_PENDING
+                       : formation.nextCentre (i) < 0              ? rnl::FsmEvent::CLUSTER_COMPLETE
+                       : (unode->msg_rec.state & SGDRONEREQ)       ? rnl::FsmEvent::RELAY_REQUEST
+                       : rnl::FsmEvent::RELAY;
+  dispatch (i, _event, &_fx);
+  commitWpts (i, &_fx);
+}
 
-          ns3::Simulator::Schedule (pkt_interval, &rnl::DroneSoc::setSender, unode, unode->source->GetNode(),
-                                        wifi_prop.tid_val(), rnl::IP_BASE + std::to_string(i+2));
-          ns3::Simulator::Schedule (2*pkt_interval, &rnl::DroneSoc::setSender, unode, unode->source->GetNode(),
-                                        wifi_prop.tid_val(), rnl::IP_BASE + std::to_string(i+3));
+void rnl::Planner::planWpts (int id, rnl::PlanEffects* fx)
+{
+  rnl::DroneSoc* unode = &nsocs[id];
 
-          std::cerr << i << " scheduled pkt with state and control: " << unode->msg_send.state << ", " << unode->msg_send.control << std::endl;
-        }
-        else
-        {
-          rnl::posHold (&unode->wpts, unode->pos);
-          unode->lookaheadindex = 0;
-          unode->toggle_bc = 1;
+  /* Commands in a fixed order, each looked up in the phase the previous one left */
+  for (const auto& _cmd : rnl::FSM_COMMANDS)
+  {
+    if (unode->msg_rec.control & _cmd.second)
+    {
+      dispatch (id, _cmd.first, fx);
+    }
+  }
+}
 
-          unode->msg_send.state = SCENTRE | SSITEREACHED | SGSITEREACHED | SGDRONEREQ;
-          unode->msg_send.control = CHOLDRC;
+void rnl::Planner::dispatch (int id, rnl::FsmEvent event, rnl::PlanEffects* fx)
+{
+  rnl::FsmPhase  _phase  = rnl::fsmPhase (nsocs[id].msg_send.state);
+  rnl::FsmAction _action = rnl::fsmLookup (_phase, event);
+  if (_action == rnl::FsmAction::NONE)
+  {
+    return;
+  }
 
-          ns3::Simulator::Schedule (2*pkt_interval, &rnl::DroneSoc::setSender, unode, unode->source->GetNode(),
-                                        wifi_prop.tid_val(), rnl::IP_BASE + std::to_string(i+unode->msg_send.neigh_cnt));
-          
-          std::cerr << i << " scheduled pkt with state and control: " << unode->msg_send.state << ", " << unode->msg_send.control << std::endl;
-        }
-      }
-    }
+  auto _t0 = std::chrono::steady_clock::now ();
+  try
+  {
+    runAction (_action, id, fx);
   }
+  catch(const std::exception& e)
+  {
+    fx->log << e.what() << '\n';
+  }
+  fx->fired.push_back ({_phase, event, std::chrono::duration<double> (std::chrono::steady_clock::now () - _t0).count ()});
 }
 
-void rnl::Planner::updateWpts (int id)
+void rnl::Planner::runAction (rnl::FsmAction action, int id, rnl::PlanEffects* fx)
 {
   rnl::DroneSoc* unode = &nsocs[id];
-  
-  if ((unode->msg_rec.control & CHOLDRC) && !(unode->msg_send.state & (SSITEREACHED | SANCHORING)))
+
+  switch (action)
   {
-    try
+    case rnl::FsmAction::HOLD_RC:
     {
-      if ((unode->msg_rec.p_loc - unode->pos).GetLength() > rnl::RC  && !rnl::Planner::siteReached (unode->pos, id))
+      if ((unode->msg_rec.p_loc - unode->pos ()).GetLength() > rnl::RC  && !rnl::Planner::siteReached (unode->pos (), id))
       {
-        rnl::getToCircleRange (&unode->wpts, unode->msg_rec.p_loc, unode->wpts[unode->lookaheadindex], rnl::RC, rnl::STEP );
-        unode->lookaheadindex = 0;
+        /* Still on the path built for this parent location, nothing to rebuild */
+        const rnl::CircleCache& _c = unode->circle_cache;
+        if (_c.valid && _c.path_gen == unode->path_gen && _c.radius == rnl::RC
+            && ns3::CalculateDistance (_c.anchor, unode->msg_rec.p_loc) <= rnl::CIRCLE_TOL)
+        {
+          break;
+        }
+        rnl::getToCircleRange (&unode->traj, unode->msg_rec.p_loc, hot.lookAhead (id), rnl::RC, &fx->log);
+        unode->startPath ();
+        unode->circle_cache = rnl::CircleCache {true, unode->msg_rec.p_loc, rnl::RC, unode->path_gen};
       }
+      break;
     }
-    catch(const std::exception& e)
-    {
-      std::cerr << e.what() << '\n';
-    }
-  }
 
-  if ((unode->msg_rec.control & CCHANGEPAR) && !(unode->msg_send.state & (SSITEREACHED | SANCHORING | SCHANGEPAR)))
-  {
-    try
+    case rnl::FsmAction::CHANGE_PARENT:
     {
-      if ((unode->msg_rec.p_loc - unode->pos).GetLength() > rnl::RC && !rnl::Planner::siteReached (unode->pos, id))
+      if ((unode->msg_rec.p_loc - unode->pos ()).GetLength() > rnl::RC && !rnl::Planner::siteReached (unode->pos (), id))
       {
-        rnl::getToCircleRange (&unode->wpts, unode->msg_rec.p_loc, unode->pos, rnl::RC, rnl::STEP );
+        rnl::getToCircleRange (&unode->traj, unode->msg_rec.p_loc, unode->pos (), rnl::RC, &fx->log);
         
-        unode->lookaheadindex = 0;
+        unode->startPath ();
         unode->msg_send.state = (SCHANGEPAR | SONLINE | SGSITEREACHED | SGDRONEREQ);
-        ns3::Simulator::Schedule ( 2*pkt_interval, &rnl::DroneSoc::setSender, unode, unode->source->GetNode(),
-                                        wifi_prop.tid_val(), rnl::IP_BASE + std::to_string(unode->id+2));
+        fx->retarget.emplace_back (2*pkt_interval, rnl::nodeAddress (unode->id+1));
       }
+      break;
     }
-    catch(const std::exception& e)
-    {
-      std::cerr << e.what() << '\n';
-    }
-  }
-  
-  if ((unode->msg_rec.control & CRTOP) && !(unode->msg_send.state & (SSITEREACHED | SANCHORING))) 
-  {
-    try
+
+    case rnl::FsmAction::ANCHOR_RIGHT:
     {
-      if ((unode->pos - unode->msg_rec.p_loc).GetLength() > rnl::RC)
+      if ((unode->pos () - unode->msg_rec.p_loc).GetLength() > rnl::RC)
       {
-        std::cerr << (unode->pos - unode->msg_rec.p_loc).GetLength()<< " is greater than rc"<<std::endl;
+        fx->log << (unode->pos () - unode->msg_rec.p_loc).GetLength()<< " is greater than rc"<<std::endl;
       }
       
-      unode ->circle_dir = 1;
-      std::cerr << unode->id << " has received CRTOP command" <<std::endl;
+      fx->log << unode->id << " has received CRTOP command" <<std::endl;
 
-      ns3::Vector3D posNew(unode->msg_rec.p_loc.x, unode->msg_rec.p_loc.y - rnl::RC, unode->msg_rec.p_loc.z);
-      rnl::getTrajectory (&unode->wpts, unode->pos, posNew, rnl::STEP);
-      unode->lookaheadindex = 0;
+      ns3::Vector3D posNew = unode->msg_rec.p_loc + formation.offsetFromParent (unode->id);
+      rnl::getTrajectory (&unode->traj, unode->pos (), posNew, &fx->log);
+      unode->startPath ();
       unode->msg_send.state = (SANCHORING | SRIGHT | SGSITEREACHED | SGDRONEREQ);
       
-      unode->anch_id = unode->msg_rec.p_id;
-      unode->anch_pos = unode->msg_rec.p_loc;
+      hot.setAnchor (unode->id, unode->msg_rec.p_id, unode->msg_rec.p_loc, 1);
       unode->msg_send.control = (CCHANGEPAR);
       unode->msg_send.p_loc = unode->msg_rec.p_loc;
       unode->msg_send.p_id = unode->msg_rec.p_id;
       
-      ns3::Simulator::Schedule ( 2*pkt_interval, &rnl::DroneSoc::setSender, unode, unode->source->GetNode(),
-                                      wifi_prop.tid_val(), rnl::IP_BASE + std::to_string(unode->msg_rec.p_id+3+1));
-    }
-    catch(const std::exception& e)
-    {
-      std::cerr << e.what() << '\n';
+      fx->retarget.emplace_back (2*pkt_interval, rnl::nodeAddress (unode->id+1));
+      break;
     }
-  }
 
-  if ((unode->msg_rec.control & CLTOP) && !(unode->msg_send.state & (SSITEREACHED | SANCHORING)))
-  {
-    try
+    case rnl::FsmAction::ANCHOR_LEFT:
     {
-      std::cerr << unode->id << " has received CLTOP command" <<std::endl;
-      ns3::Vector3D posNew(unode->msg_rec.p_loc.x, unode->msg_rec.p_loc.y + rnl::RC, unode->msg_rec.p_loc.z);
-      rnl::getTrajectory (&unode->wpts, unode->pos, posNew, rnl::STEP);
+      fx->log << unode->id << " has received CLTOP command" <<std::endl;
+      ns3::Vector3D posNew = unode->msg_rec.p_loc + formation.offsetFromParent (unode->id);
+      rnl::getTrajectory (&unode->traj, unode->pos (), posNew, &fx->log);
       
-      unode ->circle_dir = -1;
-      unode->lookaheadindex = 0;
+      unode->startPath ();
       unode->msg_send.state = (SANCHORING | SLEFT | SGSITEREACHED | SGDRONEREQ);
       unode->msg_send.control = (CCHANGEPAR);
-      unode->anch_pos = unode->msg_rec.p_loc;
-      unode->anch_id = unode->msg_rec.p_id;
+      hot.setAnchor (unode->id, unode->msg_rec.p_id, unode->msg_rec.p_loc, -1);
       unode->msg_send.p_loc = unode->msg_rec.p_loc;
       unode->msg_send.p_id = unode->msg_rec.p_id;
 
-      ns3::Simulator::Schedule ( 2*pkt_interval, &rnl::DroneSoc::setSender, unode, unode->source->GetNode(),
-                                    wifi_prop.tid_val(), rnl::IP_BASE + std::to_string(unode->msg_rec.p_id+2+1));
+      fx->retarget.emplace_back (2*pkt_interval, rnl::nodeAddress (unode->id+1));
 
-      start_left = 0;
-    }
-    catch(const std::exception& e)
-    {
-      std::cerr << e.what() << '\n';
+      fx->hold_recruit = true;
+      break;
     }
-  }
 
-  if ((unode->msg_rec.control & CBTOP) && !(unode->msg_send.state & (SSITEREACHED | SANCHORING)))
-  {
-    try
+    case rnl::FsmAction::ANCHOR_BEHIND:
     {
-      std::cerr << unode->id << " has received CBTOP command" <<std::endl;
-      ns3::Vector3D posNew(unode->msg_rec.p_loc.x - rnl::RC, unode->msg_rec.p_loc.y, unode->msg_rec.p_loc.z);
-      rnl::getTrajectory (&unode->wpts, unode->pos, posNew, rnl::STEP);
+      fx->log << unode->id << " has received CBTOP command" <<std::endl;
+      ns3::Vector3D posNew = unode->msg_rec.p_loc + formation.offsetFromParent (unode->id);
+      rnl::getTrajectory (&unode->traj, unode->pos (), posNew, &fx->log);
       
-      unode ->circle_dir = 0;
-      unode->lookaheadindex = 0;
+      unode->startPath ();
       unode->msg_send.state = (SANCHORING | SCENTRE | SGSITEREACHED | SGDRONEREQ);
       unode->msg_send.control = (CHOLDRC);
-      unode->anch_pos = unode->msg_rec.p_loc;
-      unode->anch_id = unode->msg_rec.p_id;
-      unode->msg_send.p_loc = unode->pos;
+      hot.setAnchor (unode->id, unode->msg_rec.p_id, unode->msg_rec.p_loc, 0);
+      unode->msg_send.p_loc = unode->pos ();
       unode->msg_send.p_id = unode->id;
 
-      ns3::Simulator::Schedule ( 2*pkt_interval, &rnl::DroneSoc::setSender, unode, unode->source->GetNode(),
-                                        wifi_prop.tid_val(), rnl::IP_BASE + std::to_string(unode->id+2));
+      fx->retarget.emplace_back (2*pkt_interval, rnl::nodeAddress (unode->id+1));
+      break;
+    }
+
+    case rnl::FsmAction::SETTLE_ARM:
+    {
+      if(unode->msg_rec.state & SGDRONEREQ)
+      {
+        rnl::posHold (&unode->traj, unode->pos ());
+        unode->startPath ();
+      }
+      
+      unode->msg_send.state &= SLAWNMOVERING;
+      unode->msg_send.state |= (SSITEREACHED | SGSITEREACHED) | (unode->msg_rec.state & SGDRONEREQ);
+      unode->msg_send.control = 0;
+      unode->toggle_bc = 1;
+
+      if(formation.side (id) > 0){
+        unode->msg_send.state |= SLEFT;
+      }
+      if(formation.side (id) < 0){
+        unode->msg_send.state |= SRIGHT;
+      }
+
+      fx->retarget.emplace_back (2*pkt_interval, rnl::nodeAddress (formation.centreOf (id)));
+
+      fx->log << id << " scheduled pkt with state and control: " << unode->msg_send.state << ", " << unode->msg_send.control << std::endl;
+      break;
+    }
+
+    case rnl::FsmAction::CENTRE_ARRIVE:
+    {
+      unode->msg_send.neigh_cnt = 1;
+      fx->log << "Centre Site Reached First time" <<std::endl;
+      if(id==0)
+      {
+        unode->msg_rec.state = SGDRONEREQ;
+      }
+      unode->msg_send.state = SCENTRE | SSITEREACHED | SGSITEREACHED;
+      fx->hold_recruit = true;
+      break;
+    }
+
+    case rnl::FsmAction::RECRUIT_KID:
+    {
+      int _kid = formation.children (id)[unode->msg_send.neigh_cnt-1];
+      rnl::posHold (&unode->traj, unode->pos ());
+      unode->startPath ();
+      unode->toggle_bc = 1;
+
+      unode->msg_send.state = SCENTRE | SSITEREACHED | SGSITEREACHED | SGDRONEREQ;
+      /* The first child waits for the recruit hold @see holdRecruit */
+      if(unode->msg_send.neigh_cnt > 1 || ns3::Simulator::Now () >= recruit_at)
+      {
+        unode->msg_send.control = formation.recruitControl (_kid);
+      }
+
+      fx->retarget.emplace_back (ns3::Time (0), rnl::nodeAddress (_kid));
+
+      fx->log << id << " scheduled pkt with state and control: " << unode->msg_send.state << ", " << unode->msg_send.control << std::endl;
+      break;
     }
-    catch(const std::exception& e)
+
+    case rnl::FsmAction::HOLD_CLUSTER:
+    case rnl::FsmAction::RELAY:
     {
-      std::cerr << e.what() << '\n';
+      rnl::posHold (&unode->traj, unode->pos ());
+      unode->startPath ();
+      unode->toggle_bc = 1;
+
+      unode->msg_send.state = SCENTRE | SSITEREACHED | SGSITEREACHED;
+      unode->msg_send.control = 0;
+
+      unode->msg_rec.state &= ~SGDRONEREQ;
+
+      /* One multicast reaches the previous centre, the arms and the next centre @see joinClusterGroups */
+      bool _hold = action == rnl::FsmAction::HOLD_CLUSTER;
+      fx->retarget.emplace_back (_hold ? pkt_interval : ns3::Time (0), clusterGroup (id));
+      fx->start_scans = _hold;
+
+      fx->log << id << " scheduled pkt with state and control: " << unode->msg_send.state << ", " << unode->msg_send.control << std::endl;
+      break;
     }
+
+    case rnl::FsmAction::FORWARD_REQUEST:
+    {
+      rnl::posHold (&unode->traj, unode->pos ());
+      unode->startPath ();
+      unode->toggle_bc = 1;
+
+      unode->msg_send.state = SCENTRE | SSITEREACHED | SGSITEREACHED | SGDRONEREQ;
+      unode->msg_send.control = CHOLDRC;
+
+      /* The next centre, or the tail for the last one */
+      fx->retarget.emplace_back (2*pkt_interval, rnl::nodeAddress (formation.towardBase (id)));
+
+      fx->log << id << " scheduled pkt with state and control: " << unode->msg_send.state << ", " << unode->msg_send.control << std::endl;
+      break;
+    }
+
+    case rnl::FsmAction::NONE:
+      break;
+  }
+}
+
+void rnl::Planner::commitWpts (int id, rnl::PlanEffects* fx)
+{
+  rnl::DroneSoc* unode = &nsocs[id];
+  std::cerr << fx->log.str ();
+  for (const auto& _r : fx->retarget)
+  {
+    ns3::Simulator::Schedule (_r.first, &rnl::DroneSoc::setSender, unode, unode->source->GetNode(),
+                                    wifi_prop.tid_val(), _r.second);
+  }
+  if (fx->hold_recruit)
+  {
+    holdRecruit ();
+  }
+  if (fx->start_scans && !scan_scheduled)
+  {
+    scan_scheduled = true;
+    for (int c : formation.centres ())
+    {
+      ns3::Simulator::Schedule (ns3::Seconds (rnl::SCAN_HOLD), &rnl::Planner::doLawnMoverScanning, this, c);
+    }
+  }
+  for (const auto& _f : fx->fired)
+  {
+    fsm_stats.record (_f.phase, _f.event, _f.seconds);
+  }
+  unode->syncState ();
+
+  fx->log.str ("");
+  fx->retarget.clear ();
+  fx->hold_recruit = false;
+  fx->start_scans = false;
+  fx->fired.clear ();
+}
+
+void rnl::Planner::updateWpts (int id)
+{
+  rnl::PlanEffects _fx;
+  planWpts (id, &_fx);
+  commitWpts (id, &_fx);
+}
+
+void rnl::Planner::updateWpts (const std::vector<int>& ids)
+{
+  /* Each drone only reads its own messages and writes its own DroneSoc and store entries,
+     so the planning runs on the pool; the rest is committed in ID order, as the serial loop did */
+  if (plan_fx.size () < nsocs.size ())
+  {
+    plan_fx.resize (nsocs.size ());
+  }
+  pool.parallelFor (static_cast<int> (ids.size ()), [this, &ids] (int k) { planWpts (ids[k], &plan_fx[ids[k]]); });
+  for (int id : ids)
+  {
+    commitWpts (id, &plan_fx[id]);
   }
 }
 
 bool rnl::Planner::withinThreshold (const rnl::DroneSoc* _soc)
 {
-  ns3::Vector3D _lka = _soc->wpts[_soc->lookaheadindex];
-  ns3::Vector3D _cpos = _soc -> pos;
-  return ns3::CalculateDistance (_lka, _cpos) < 0.5;
+  return ns3::CalculateDistance (hot.lookAhead (_soc->id), hot.position (_soc->id)) < 0.5;
 }
 
 void rnl::Planner::incLookAhead ()
 {
-  for (int i = 0; i< nsocs.size(); ++i)
+  /* Test every drone over the store first, only the drones that move on touch their path */
+  hot.reachedLookAhead (0.5, &la_hit);
+  for (int i = 0; i < hot.size (); ++i)
   {
-    if (nsocs[i].lookaheadindex + 1 < nsocs[i].wpts.size() && withinThreshold(&nsocs[i]))
+    if (la_hit[i])
     {
-      nsocs[i].lookaheadindex ++;
+      nsocs[i].setLookAhead (nsocs[i].traj.advance (hot.la_s[i], rnl::STEP));
     }
   }
+  for (int i : coverage.scanners ())
+  {
+    replayCoverage (i);
+  }
+}
+
+void rnl::Planner::incLookAhead (int i)
+{
+  if (hot.hasPathAhead (i) && withinThreshold(&nsocs[i]))
+  {
+    nsocs[i].setLookAhead (nsocs[i].traj.advance (hot.la_s[i], rnl::STEP));
+  }
+  replayCoverage (i);
 }
 
 void rnl::Planner::updatePosSocs ()
 {
-  for (int i = 0; i < nsocs.size(); ++i)
+  for (int i = 0; i < hot.size (); ++i)
   {
-    rnl::setPosition(wifi_prop.c.Get(i), nsocs[i].pos);
+    rnl::setPosition(wifi_prop.c.Get(i), hot.position (i));
+    grid.update (i, hot.position (i));
   }
 }
 
 void rnl::Planner::updateSocsfromRec ()
 {
+  plan_ids.clear ();
   for (int i = 1; i < nsocs.size(); ++i)
   {
-    updateWpts(i);
+    plan_ids.push_back (i);
   }
+  updateWpts (plan_ids);
 }
 
-void rnl::Planner::doLawnMoverScanning (ns3::Time interval, int id, ns3::Vector3D pos0)
+void rnl::Planner::doLawnMoverScanning (int centre)
 {
-  std::cerr << "----------doLawnMoverScanning called----------"<< std::endl;
-
-  int dir = 1;
-  if(id%3 == 1)
+  std::vector<int> _arms;
+  for (int id : formation.children (centre))
   {
-    dir = 1;
+    if (formation.isArm (id) && !coverage.assigned (id))
+    {
+      _arms.push_back (id);
+    }
   }
-  else if(id%3 == 2)
+  if (_arms.empty ())
   {
-    dir = -1;
+    return;
   }
+  std::cerr << "----------doLawnMoverScanning called for cluster " << centre << "----------"<< std::endl;
 
-  rnl::DroneSoc* unode = &nsocs[id];
-
-  ns3::Simulator::ScheduleNow (&rnl::DroneSoc::setSenderTCP, unode, unode->source->GetNode(), rnl::IP_BASE + std::to_string(id+1),
-   rnl::IP_BASE + std::to_string(num_nodes), ns3::Seconds (150 + 3*id));
+  std::vector<ns3::Vector3D> _from;
+  for (int id : _arms)
+  {
+    _from.push_back (nsocs[id].pos ());
+  }
 
-  if((id-1)%3 == 0)
+  const double _now = ns3::Simulator::Now ().GetSeconds ();
+  if (scan_area.empty ())
+  {
+    /* Each arm scans its own box, RC/3.2 by RC/2 around its slot like the fixed lawn mover
+     * pattern, so no lane passes over the centre */
+    for (size_t k = 0; k < _arms.size (); ++k)
+    {
+      ns3::Vector3D _s = formation.slotPos (_arms[k], disas_centre);
+      rnl::Coverage::Polygon _box = {ns3::Vector3D (_s.x - rnl::RC/3.2, _s.y - rnl::RC/2, _s.z),
+                                     ns3::Vector3D (_s.x + rnl::RC/3.2, _s.y - rnl::RC/2, _s.z),
+                                     ns3::Vector3D (_s.x + rnl::RC/3.2, _s.y + rnl::RC/2, _s.z),
+                                     ns3::Vector3D (_s.x - rnl::RC/3.2, _s.y + rnl::RC/2, _s.z)};
+      coverage.assign (_box, {_arms[k]}, {_from[k]}, _now);
+    }
+  }
+  else
   {
-    int temp_id = id-1;
+    ns3::Vector3D _c = formation.slotPos (centre, disas_centre);
+    rnl::Coverage::Polygon _area;
+    for (const ns3::Vector3D& _p : scan_area)
+    {
+      _area.push_back (_c + _p);
+    }
+    coverage.assign (_area, _arms, _from, _now);
+  }
 
-    rnl::DroneSoc* temp_unode = &nsocs[temp_id];
+  /* The centre does not scan, its upload starts with its arms */
+  rnl::DroneSoc* cnode = &nsocs[centre];
+  offload.startJob (centre, cnode->source->GetNode(), rnl::nodeAddress (num_nodes-1), ns3::Seconds (150 + 3*centre));
 
-    ns3::Simulator::ScheduleNow (&rnl::DroneSoc::setSenderTCP, temp_unode, temp_unode->source->GetNode(), rnl::IP_BASE + std::to_string(temp_id+1),
-      rnl::IP_BASE + std::to_string(num_nodes), ns3::Seconds (150 + 3*temp_id));
-  }
+  for (int id : _arms)
+  {
+    rnl::DroneSoc* unode = &nsocs[id];
 
-  ns3::Vector3D pos1(pos0.x + rnl::RC/3.2, pos0.y + dir*rnl::RC/2, pos0.z);
-  ns3::Vector3D pos2(pos0.x - rnl::RC/3.2, pos0.y + dir*rnl::RC/2, pos0.z);
-  ns3::Vector3D pos3(pos0.x - rnl::RC/3.2, pos0.y                , pos0.z);
-  ns3::Vector3D pos4(pos0.x + rnl::RC/3.2, pos0.y                , pos0.z);
-  ns3::Vector3D pos5(pos0.x + rnl::RC/3.2, pos0.y - dir*rnl::RC/4, pos0.z);
-  ns3::Vector3D pos6(pos0.x - rnl::RC/3.2, pos0.y - dir*rnl::RC/4, pos0.z);
-  ns3::Vector3D pos7(pos0.x - rnl::RC/3.2, pos0.y - dir*rnl::RC/2, pos0.z);
-  ns3::Vector3D pos8(pos0.x + rnl::RC/3.2, pos0.y - dir*rnl::RC/2, pos0.z);
+    offload.startJob (id, unode->source->GetNode(), rnl::nodeAddress (num_nodes-1), ns3::Seconds (150 + 3*id));
 
-  rnl::getTrajectory (&unode->wpts, pos0, pos1, rnl::STEP);
-  rnl::getTrajectoryContinue (&unode->wpts, pos1, pos2, rnl::STEP);
-  rnl::getTrajectoryContinue (&unode->wpts, pos2, pos3, rnl::STEP);
-  rnl::getTrajectoryContinue (&unode->wpts, pos3, pos4, rnl::STEP);
-  rnl::getTrajectoryContinue (&unode->wpts, pos4, pos5, rnl::STEP);
-  rnl::getTrajectoryContinue (&unode->wpts, pos5, pos6, rnl::STEP);
-  rnl::getTrajectoryContinue (&unode->wpts, pos6, pos7, rnl::STEP);
-  rnl::getTrajectoryContinue (&unode->wpts, pos7, pos8, rnl::STEP);
-  rnl::getTrajectoryContinue (&unode->wpts, pos8, pos0, rnl::STEP);
+    unode->traj = coverage.path (id);
+    unode->startPath ();
+    unode->scan_gen = unode->path_gen;
+    unode->markDirty ();
 
-  unode->lookaheadindex = 0;
+    std::cerr << id << " lawn movering..."<< std::endl;
 
-  std::cerr << id << " lawn movering..."<< std::endl;
+    unode->msg_rec.state &= ~SGDRONEREQ;
+    unode->msg_send.state = SLAWNMOVERING | SGSITEREACHED | SSITEREACHED;
 
-  nsocs[id].msg_rec.state &= ~SGDRONEREQ;
-  nsocs[id].msg_send.state = SLAWNMOVERING | SGSITEREACHED | SSITEREACHED;
+    if(formation.side (id) > 0)
+    {
+      unode->msg_send.state |= SLEFT;
+    }
+    else if(formation.side (id) < 0)
+    {
+      unode->msg_send.state |= SRIGHT;
+    }
+    unode->syncState ();
+  }
+}
+
+void rnl::Planner::replayCoverage (int i)
+{
+  rnl::DroneSoc* unode = &nsocs[i];
+  if (!(hot.state[i] & SLAWNMOVERING) || !coverage.scans (i) || hot.hasPathAhead (i) || !withinThreshold (unode))
+  {
+    return;
+  }
 
-  if(id%3 == 1)
+  if (unode->path_gen == unode->scan_gen)
   {
-    nsocs[id].msg_send.state |= SLEFT;
+    coverage.lapDone (i, ns3::Simulator::Now ().GetSeconds ());
   }
-  else if(id%3 == 2)
+  else if (unode->msg_rec.state & SGDRONEREQ)
   {
-    nsocs[id].msg_send.state |= SRIGHT;
+    /* Holding while the swarm asks for drones */
+    return;
   }
-
-  ns3::Simulator::Schedule(interval, &rnl::Planner::doLawnMoverScanning, this, interval, id, pos0);
+  else
+  {
+    /* Another path took over and is done, go back to scanning */
+    unode->traj = coverage.path (i);
+    unode->startPath ();
+    unode->scan_gen = unode->path_gen;
+  }
+  unode->setLookAhead (unode->traj.advance (coverage.cycleStart (i), rnl::STEP));
 }
 
 void rnl::Planner::updateSocs ()
 {
-  for (int i = 1; i < tail_id; ++i)
+  for (int i = 1; i < formation.numSlots (); ++i)
   {
-    if (rnl::Planner::siteReached (nsocs[i].pos, i) && i%3 > 0)
-    {
-      if(nsocs[i].msg_rec.state & SGDRONEREQ)
-      {
-        rnl::posHold (&nsocs[i].wpts, nsocs[i].pos);
-        nsocs[i].lookaheadindex = 0;
-      }
-      
-      nsocs[i].msg_send.state &= SLAWNMOVERING;
-      nsocs[i].msg_send.state |= (SSITEREACHED | SGSITEREACHED) | (nsocs[i].msg_rec.state & SGDRONEREQ);
-      nsocs[i].msg_send.control = 0;
-      nsocs[i].toggle_bc = 1;
-
-      if(i%3 == 1){
-        nsocs[i].msg_send.state |= SLEFT;
-      }
-      if(i%3 == 2){
-        nsocs[i].msg_send.state |= SRIGHT;
-      }
-
-      rnl::DroneSoc* unode = &nsocs[i];
-
-      ns3::Simulator::Schedule (2*pkt_interval, &rnl::DroneSoc::setSender, unode, unode->source->GetNode(),
-                                        wifi_prop.tid_val(), rnl::IP_BASE + std::to_string(i-(i%3)+1));
+    updateSoc (i);
+  }
+}
 
-      std::cerr << i << " scheduled pkt with state and control: " << unode->msg_send.state << ", " << unode->msg_send.control << std::endl;
-    }
+void rnl::Planner::updateSoc (int i)
+{
+  rnl::PlanEffects _fx;
+  if (rnl::Planner::siteReached (nsocs[i].pos (), i) && formation.isArm (i))
+  {
+    dispatch (i, rnl::FsmEvent::SLOT_REACHED, &_fx);
   }
+  commitWpts (i, &_fx);
 } 
 
 void rnl::Planner::advancePos (ns3::Time interval)
 {
   ros::spinOnce();
+  if (event_driven)
+  {
+    advanceDirty ();
+    ns3::Simulator::Schedule(interval, &rnl::Planner::advancePos, this, interval);
+    return;
+  }
+
   updatePosSocs ();
   incLookAhead ();
   updateStateofCentre ();
@@ -900,7 +1198,7 @@ void rnl::Planner::advancePos (ns3::Time interval)
 
   for (int i = 0; i < nsocs.size(); ++i)
   {
-    if (nsocs[i].wpts.size())
+    if (hot.hasPath (i))
     {
       nsocs[i].publishLookAhead();
     }
@@ -908,6 +1206,208 @@ void rnl::Planner::advancePos (ns3::Time interval)
   ns3::Simulator::Schedule(interval, &rnl::Planner::advancePos, this, interval);
 }
 
+void rnl::Planner::advanceDirty ()
+{
+  /* Evaluate in ID order, the same order as the polling loops */
+  eval_ids.swap (dirty_ids);
+  dirty_ids.clear ();
+  std::sort (eval_ids.begin (), eval_ids.end ());
+
+  for (int i : eval_ids)
+  {
+    nsocs[i].dirty    = false;
+    nsocs[i].eval_pos = hot.position (i);
+    rnl::setPosition (wifi_prop.c.Get(i), hot.position (i));
+    grid.update (i, hot.position (i));
+    incLookAhead (i);
+  }
+
+  /* A centre depends on the positions of its cluster, evaluate it once if any member changed */
+  int last_centre = -1;
+  for (int i : eval_ids)
+  {
+    int centre = formation.centreOf (i);
+    if (centre >= 0 && centre != last_centre)
+    {
+      updateCentre (centre);
+      last_centre = centre;
+    }
+  }
+
+  plan_ids.clear ();
+  for (int i : eval_ids)
+  {
+    if (i >= 1)
+    {
+      plan_ids.push_back (i);
+    }
+  }
+  updateWpts (plan_ids);
+
+  for (int i : eval_ids)
+  {
+    if (i >= 1 && formation.hasSlot (i))
+    {
+      updateSoc (i);
+    }
+  }
+
+  for (int i : eval_ids)
+  {
+    if (hot.hasPath (i))
+    {
+      nsocs[i].publishLookAhead();
+    }
+    /* Drones still following a path stay dirty, idle ones wait for the next event */
+    if (hot.hasPathAhead (i))
+    {
+      nsocs[i].markDirty ();
+    }
+  }
+  eval_ids.clear ();
+}
+
+std::string rnl::Planner::clusterGroup (int centre)
+{
+  int host = centre + 257;
+  return rnl::MCAST_BASE + std::to_string (host >> 8) + "." + std::to_string (host & 0xff);
+}
+
+void rnl::Planner::joinClusterGroups ()
+{
+  for (int i : formation.centres ())
+  {
+    /* The previous centre, the arms and the next centre */
+    if (formation.prevCentre (i) >= 0)
+    {
+      wifi_prop.JoinGroup (wifi_prop.c.Get(formation.prevCentre (i)), clusterGroup (i));
+    }
+    for (int member : formation.children (i))
+    {
+      wifi_prop.JoinGroup (wifi_prop.c.Get(member), clusterGroup (i));
+    }
+  }
+  /* The tail relays for the last centre, which has no next centre */
+  if (!formation.centres ().empty () && formation.tailId () < formation.baseId ())
+  {
+    wifi_prop.JoinGroup (wifi_prop.c.Get(formation.tailId ()), clusterGroup (formation.centres ().back ()));
+  }
+}
+
+void rnl::Planner::reslot ()
+{
+  hot.positions (&slot_pos);
+  int _before = slots.numSlots ();
+  slots.reslot (slot_pos);
+  if (slots.numSlots () != _before)
+  {
+    std::cerr << "TDMA frame: " << slots.numSlots () << " slots of " << pkt_interval.GetSeconds () << " s" << std::endl;
+  }
+}
+
+void rnl::Planner::reslotTick (ns3::Time interval)
+{
+  reslot ();
+  checkSeparation ();
+  ns3::Simulator::Schedule (interval, &rnl::Planner::reslotTick, this, interval);
+}
+
+int rnl::Planner::checkSeparation ()
+{
+  grid.pairsWithin (rnl::SEP_MIN, &close_pairs);
+  for (const auto& _p : close_pairs)
+  {
+    std::cerr << "Drones " << _p.first << " and " << _p.second << " are "
+              << ns3::CalculateDistance (hot.position (_p.first), hot.position (_p.second))
+              << " m apart at " << ns3::Simulator::Now ().GetSeconds () << std::endl;
+  }
+  return static_cast<int> (close_pairs.size ());
+}
+
+const rnl::SpatialGrid& rnl::Planner::spatialGrid () const
+{
+  return grid;
+}
+
+void rnl::Planner::joinDrone (int id)
+{
+  slots.join (id);
+  reslot ();
+
+  rnl::DroneSoc& _soc = nsocs[id];
+  ns3::Time      _now = ns3::Simulator::Now ();
+  if (!_soc.sending)
+  {
+    std::cerr << id << " joined the TDMA schedule, sends again" << std::endl;
+    _soc.sending = true;
+    ns3::Simulator::Schedule (slots.nextUnicast (id, _now) - _now, &rnl::DroneSoc::sendPacket, &_soc, pkt_interval, num_nodes);
+  }
+  if (!_soc.beaconing)
+  {
+    _soc.beaconing = true;
+    ns3::Simulator::Schedule (slots.nextBroadcast (id, _now) - _now, &rnl::DroneSoc::sendBcPacket, &_soc, pkt_interval, num_nodes);
+  }
+}
+
+void rnl::Planner::leaveDrone (int id)
+{
+  slots.leave (id);
+  reslot ();
+}
+
+void rnl::Planner::wake (int id)
+{
+  nsocs[id].markDirty ();
+}
+
+void rnl::Planner::holdRecruit ()
+{
+  recruit_at = ns3::Simulator::Now () + ns3::Seconds (rnl::RECRUIT_HOLD);
+  for (int c : formation.centres ())
+  {
+    ns3::Simulator::Schedule (ns3::Seconds (rnl::RECRUIT_HOLD), &rnl::Planner::wake, this, c);
+  }
+}
+
+void rnl::Planner::setEventDriven (bool on)
+{
+  event_driven = on;
+}
+
+void rnl::Planner::setFormation (const rnl::Formation& f)
+{
+  formation = f;
+}
+
+void rnl::Planner::setOffload (const rnl::Offload::Config& cfg)
+{
+  offload.configure (cfg);
+}
+
+void rnl::Planner::setFlowStats (ns3::Time interval)
+{
+  flow_interval = interval;
+}
+
+void rnl::Planner::setPlanThreads (int threads)
+{
+  pool.start (threads);
+  std::cerr << "Planning on " << pool.size () << " threads" << std::endl;
+}
+
+void rnl::Planner::setDropout (int id, ns3::Time at, ns3::Time duration)
+{
+  drop_id  = id;
+  drop_at  = at;
+  drop_for = duration;
+}
+
+void rnl::Planner::setCoverage (const rnl::Coverage::Polygon& area, double width)
+{
+  scan_area = area;
+  coverage.setWidth (width);
+}
+
 void rnl::Planner::takeOff (double _t)
 {
   if ((ns3::Simulator::Now ().GetSeconds() - _t) < 1)
@@ -925,20 +1425,114 @@ void rnl::Planner::startSimul()
 {
   for (int i =0; i< nsocs.size(); ++i)
   {
-    ns3::Simulator::Schedule (ns3::Seconds (2.0) + i*pkt_interval, &rnl::DroneSoc::sendPacket, &nsocs[i], pkt_interval, num_nodes);
+    slots.join (i);
+    nsocs[i].slots = &slots;
+    ns3::Config::ConnectWithoutContext ("/NodeList/" + std::to_string (i) + "/DeviceList/*/$ns3::WifiNetDevice/Phy/State/State",
+                                        ns3::MakeCallback (&rnl::DroneSoc::phyStateCb, &nsocs[i]));
     nsocs[i].setRecv (wifi_prop.c.Get(i), wifi_prop.tid_val());
     nsocs[i].initializeRosParams (nh);
 
   }
   initializeMobility();
 
-  nsocs[num_nodes-1].setRecvTCP (wifi_prop.c.Get(num_nodes-1), rnl::IP_BASE + std::to_string(num_nodes-1), num_nodes, stopTime);
+  reslot ();
+  for (int i =0; i< nsocs.size(); ++i)
+  {
+    nsocs[i].sending   = true;
+    nsocs[i].beaconing = true;
+    ns3::Simulator::Schedule (slots.nextUnicast (i, ns3::Seconds (2.0)) - ns3::Simulator::Now (), &rnl::DroneSoc::sendPacket, &nsocs[i], pkt_interval, num_nodes);
+    ns3::Simulator::Schedule (slots.nextBroadcast (i, ns3::Seconds (2.0)) - ns3::Simulator::Now (), &rnl::DroneSoc::sendBcPacket, &nsocs[i], pkt_interval, num_nodes);
+  }
+  if (drop_id >= 0 && drop_id < num_nodes)
+  {
+    ns3::Simulator::Schedule (drop_at, &rnl::Planner::leaveDrone, this, drop_id);
+    ns3::Simulator::Schedule (drop_at + drop_for, &rnl::Planner::joinDrone, this, drop_id);
+  }
+  ns3::Simulator::Schedule (ns3::Seconds (rnl::RESLOT_INTERVAL), &rnl::Planner::reslotTick, this, ns3::Seconds (rnl::RESLOT_INTERVAL));
+
+  /* nsocs is final from here on, so the queue pointers stay valid. Everyone starts dirty */
+  dirty_ids.reserve (nsocs.size ());
+  eval_ids.reserve (nsocs.size ());
+  for (auto& _soc : nsocs)
+  {
+    _soc.dirty_queue = &dirty_ids;
+    _soc.markDirty ();
+  }
+
+  offload.installSink (wifi_prop.c.Get(num_nodes-1), ns3::Seconds (80), stopTime);
+  trace.open ("pkt_rec_time.bin");
+  offload.tcpSink ()->TraceConnectWithoutContext ("Rx", ns3::MakeBoundCallback (&rnl::PacketTrace::rxTrace, &trace, static_cast<uint32_t> (num_nodes-1)));
+  offload.udpSink ()->TraceConnectWithoutContext ("Rx", ns3::MakeBoundCallback (&rnl::PacketTrace::rxTrace, &trace, static_cast<uint32_t> (num_nodes-1)));
 
   ns3::Simulator::ScheduleNow (&rnl::Planner::takeOff, this, ns3::Simulator::Now ().GetSeconds());
   ns3::Simulator::Schedule (ns3::Seconds (2.0) + 5 * (num_nodes+1) * pkt_interval, &rnl::Planner::advancePos, this, pos_interval);
   ns3::Simulator::Stop(stopTime);
   ns3::AnimationInterface anim ("planner_ns3_anim.xml");
   anim.SetMaxPktsPerTraceFile(9999999);
+  if (flow_interval.IsStrictlyPositive ())
+    flows.install (flow_interval);
   ns3::Simulator::Run();
+  reportPoolStats ();
+  reportRateStats ();
+  exportCtrlLatency ("ctrl_latency.csv");
+  offload.report ("offload.csv");
+  coverage.report ("coverage.csv");
+  trace.close ();
+  flows.write ("flows");
+  fsm_stats.write ("fsm.csv");
   ns3::Simulator::Destroy();
 }
+
+void rnl::Planner::exportCtrlLatency (const std::string& path)
+{
+  std::ofstream out (path.c_str ());
+  out << "drone,seq,control,sent,latency,retries" << std::endl;
+
+  int    _acked = 0;
+  int    _total = 0;
+  double _sum   = 0;
+  for (const auto& _soc : nsocs)
+  {
+    for (const auto& _c : _soc.ctrl_log)
+    {
+      out << _soc.id << "," << _c.seq << "," << _c.control << "," << _c.sent << "," << _c.latency << "," << _c.retries << std::endl;
+      _total++;
+      if (_c.latency >= 0)
+      {
+        _acked++;
+        _sum += _c.latency;
+      }
+    }
+    if (_soc.ctrl_active)
+    {
+      const rnl::CtrlSample& _c = _soc.ctrl_pending;
+      out << _soc.id << "," << _c.seq << "," << _c.control << "," << _c.sent << "," << _c.latency << "," << _c.retries << std::endl;
+      _total++;
+    }
+  }
+  std::cerr << "Control commands acked: " << _acked << "/" << _total
+            << ", mean latency " << (_acked ? _sum / _acked : 0) << " s, written to " << path << std::endl;
+}
+
+void rnl::Planner::reportRateStats ()
+{
+  for (const auto& _soc : nsocs)
+  {
+    const rnl::RateController::Stats& _st = _soc.rate.stats ();
+    std::cerr << _soc.id << " sent " << _st.sends << " unicasts in " << _st.frames << " frames, last busy fraction "
+              << _soc.rate.busyFraction () << std::endl;
+  }
+}
+
+void rnl::Planner::reportPoolStats ()
+{
+  for (const auto& _soc : nsocs)
+  {
+    const rnl::BufferPool::Stats& _tx = _soc.tx_pool.stats ();
+    const rnl::BufferPool::Stats& _rx = _soc.rx_pool.stats ();
+    std::cerr << _soc.id << " tx buffers: " << _tx.buffers << ", acquired: " << _tx.acquired
+              << ", heap allocations: " << _tx.allocations << std::endl;
+    std::cerr << _soc.id << " rx buffers: " << _rx.buffers << ", acquired: " << _rx.acquired
+              << ", heap allocations: " << _rx.allocations << std::endl;
+  }
+}
@@ -0,0 +1,52 @@
+#include "rate_controller.h"
+
+rnl::RateController::RateController (int _max_skip, double _busy_hi):
+k{1}, max_skip{_max_skip}, busy_hi{_busy_hi}
+{
+    busy         = 0;
+    window_start = 0;
+    busy_frac    = 0;
+}
+
+int rnl::RateController::next (bool manoeuvring, bool changed, double now)
+{
+    if (now > window_start)
+    {
+        busy_frac = busy / (now - window_start);
+    }
+    busy         = 0;
+    window_start = now;
+
+    st.sends++;
+    st.frames += k;
+
+    if (manoeuvring || changed)
+    {
+        k = 1;
+        return k;
+    }
+
+    int cap = busy_frac > busy_hi ? 2 * max_skip : max_skip;
+    k = k * 2 > cap ? cap : k * 2;
+    return k;
+}
+
+void rnl::RateController::addBusy (double seconds)
+{
+    busy += seconds;
+}
+
+double rnl::RateController::busyFraction () const
+{
+    return busy_frac;
+}
+
+int rnl::RateController::skip () const
+{
+    return k;
+}
+
+const rnl::RateController::Stats& rnl::RateController::stats () const
+{
+    return st;
+}
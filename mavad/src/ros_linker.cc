@@ -29,8 +29,8 @@ rnl::Interface::Interface (ros::NodeHandle& _nh, ros::NodeHandle& _nh_private, s
   drone_state_sub2 = nh.subscribe("/uav2/drone_data",
                       10, &rnl::Interface::localStateCb2, this);
   
-  msg1 << "0,0,0,0.0,0.0,0.0"; //Initializing the messages to 0
-  msg2 << "0,0,0,0.0,0.0,0.0";
+  getTransmitMsg (planner_msgs::DroneMsg (), &msg1); //Initializing the messages to 0
+  getTransmitMsg (planner_msgs::DroneMsg (), &msg2);
 }
 
 void rnl::Interface::initialize(bool rt , bool chsum ) 
@@ -168,14 +168,10 @@ void rnl::Interface::receivePacket1(ns3::Ptr<ns3::Socket> soc)
 
 void rnl::Interface::receivePacket2(ns3::Ptr<ns3::Socket> soc)
 {
-  std::string receivedData;
+  /*Node 2 only relays, the payload is not needed*/
   while (ns3::Ptr<ns3::Packet> msg = soc->Recv ())
   {
     std::cerr << "Node 2 received Packet at " << ns3::Simulator::Now ().GetSeconds() << std::endl;
-    uint8_t *buffer = new uint8_t[msg->GetSize ()];
-    msg->CopyData (buffer, msg->GetSize ());
-    receivedData = std::string ((char *) buffer);
-  
   }
     
   ns3::Simulator::Schedule (inter_packet_interval, &rnl::Interface::sendPacket2,this,
@@ -184,18 +180,19 @@ void rnl::Interface::receivePacket2(ns3::Ptr<ns3::Socket> soc)
 
 void rnl::Interface::receivePacket3(ns3::Ptr<ns3::Socket> soc)
 {
-  std::string receivedData;
+  planner_msgs::DroneMsg pub_msg_uav3;
   while (ns3::Ptr<ns3::Packet> msg = soc->Recv ())
   {
 	  std::cerr << "Node 3 received Packet at " << ns3::Simulator::Now ().GetSeconds() << std::endl;
-    uint8_t *buffer = new uint8_t[msg->GetSize ()];
-    msg->CopyData (buffer, msg->GetSize ());
-    receivedData = std::string ((char *) buffer);
+    rx_buf.resize (msg->GetSize ());
+    msg->CopyData (rx_buf.data (), rx_buf.size ());
+
+    /*Publishing the reveived NS3 message to ros*/
+    if (parseRecMsg (rx_buf.data (), rx_buf.size (), &pub_msg_uav3))
+      pub_node3.publish(pub_msg_uav3);
+    else
+      std::cerr << "Node 3 dropped malformed packet of " << rx_buf.size () << " bytes" << std::endl;
   }
-  /*Publishing the reveived NS3 message to ros and publishing*/  
-  planner_msgs::DroneMsg pub_msg_uav3;
-  pub_msg_uav3 = parseRecMsg (receivedData);
-  pub_node3.publish(pub_msg_uav3);
   ros::spinOnce();
 } 
 
@@ -204,7 +201,7 @@ void rnl::Interface::sendPacket1 (ns3::Ptr<ns3::Socket> soc, uint32_t pktSize, n
 {
   /*The Master node. Only sends*/
   ros::spinOnce(); // For making Subscriber Callbacks and updating msg with latest data
-	ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet> ((uint8_t*) msg1.str().c_str(), msg1.str().length());
+	ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet> (msg1.data (), msg1.size ());
 	
   std::cerr <<"Sending packet from node 1 at " << ns3::Simulator::Now().GetSeconds() << std::endl;
   soc->Send (packet);
@@ -218,7 +215,7 @@ void rnl::Interface::sendPacket2 (ns3::Ptr<ns3::Socket> soc, uint32_t pktSize, n
 {
   ros::spinOnce(); // For making Subscriber Callbacks and updating msg with latest data
   
-	ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet> ((uint8_t*) msg2.str().c_str(), msg2.str().length());
+	ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet> (msg2.data (), msg2.size ());
 	std::cerr << "Sending packet from node 2 at " << ns3::Simulator::Now().GetSeconds() << std::endl;
 	soc->Send (packet);
 }
@@ -242,15 +239,8 @@ void rnl::Interface::setPosition(ns3::Ptr<ns3::Node> node, ns3::Vector position)
 
 void rnl::Interface::localStateCb1 (const planner_msgs::DroneMsg& drone_msg)
 {
-  /*Convert the rostopic message to stringstream in sequence of rosmsg*/
-  msg1.str("");
-  msg1.clear();
-  
-  msg1  << drone_msg.id << "," << drone_msg.status << ","
-        << drone_msg.direction << "," << drone_msg.x << "," 
-        << drone_msg.y << "," << drone_msg.z;
-
-  msg1 << '\0';
+  /*Serialize the rostopic message as it is, no text conversion*/
+  getTransmitMsg (drone_msg, &msg1);
 
   ns3::Vector pos;
   pos.x = drone_msg.x;
@@ -260,15 +250,8 @@ void rnl::Interface::localStateCb1 (const planner_msgs::DroneMsg& drone_msg)
 
 void rnl::Interface::localStateCb2 (const planner_msgs::DroneMsg& drone_msg)
 {
-  /*Convert the rostopic message to stringstream in sequence of rosmsg*/
-  msg2.str("");
-  msg2.clear();
-  
-  msg2  << drone_msg.id << "," << drone_msg.status << ","
-        << drone_msg.direction << "," << drone_msg.x << "," 
-        << drone_msg.y << "," << drone_msg.z;
-          
-  msg2 << '\0';
+  /*Serialize the rostopic message as it is, no text conversion*/
+  getTransmitMsg (drone_msg, &msg2);
 
   ns3::Vector pos;
   pos.x = drone_msg.x;
@@ -276,37 +259,21 @@ void rnl::Interface::localStateCb2 (const planner_msgs::DroneMsg& drone_msg)
   setPosition(c.Get(1), pos);
 }
 
-planner_msgs::DroneMsg rnl::Interface::parseRecMsg (std::string& rc_msg) 
+void rnl::Interface::getTransmitMsg (const planner_msgs::DroneMsg& tr_msg, std::vector<uint8_t>* dst)
 {
-  /*rc_msg is parsed by delimiter and according to the rosmsg sequence temp message is prepared*/
-
-  planner_msgs::DroneMsg temp;
-  std::string delimiter = ",";
-  std::string token;
-
-  token = rc_msg.substr(0, rc_msg.find(delimiter));
-  temp.id = std::stoi(token);
-  rc_msg.erase(0, rc_msg.find(delimiter) + delimiter.length()); 
-  
-  token = rc_msg.substr(0, rc_msg.find(delimiter));
-  temp.status = std::stoi(token);
-  rc_msg.erase(0, rc_msg.find(delimiter) + delimiter.length()); 
-  
-  token = rc_msg.substr(0, rc_msg.find(delimiter));
-  temp.direction = std::stoi(token);
-  rc_msg.erase(0, rc_msg.find(delimiter) + delimiter.length()); 
-  
-  token = rc_msg.substr(0, rc_msg.find(delimiter));
-  temp.x = std::stof(token);
-  rc_msg.erase(0, rc_msg.find(delimiter) + delimiter.length()); 
-  
-  token = rc_msg.substr(0, rc_msg.find(delimiter));
-  temp.y = std::stof(token);
-  rc_msg.erase(0, rc_msg.find(delimiter) + delimiter.length()); 
-  
-  token = rc_msg.substr(0, rc_msg.find(delimiter));
-  temp.z = std::stof(token);
-  rc_msg.erase(0, rc_msg.find(delimiter) + delimiter.length()); 
+  dst->resize (ros::serialization::serializationLength (tr_msg));
+  ros::serialization::OStream stream (dst->data (), dst->size ());
+  ros::serialization::serialize (stream, tr_msg);
+}
 
-  return temp;
+bool rnl::Interface::parseRecMsg (const uint8_t* data, size_t len, planner_msgs::DroneMsg* rc_msg) 
+{
+  /*DroneMsg has a fixed size, anything else is a foreign or truncated packet.
+    Checking it up front keeps deserialize from throwing StreamOverrunException*/
+  if (len != ros::serialization::serializationLength (*rc_msg))
+    return false;
+
+  ros::serialization::IStream stream (const_cast<uint8_t*> (data), len);
+  ros::serialization::deserialize (stream, *rc_msg);
+  return true;
 }
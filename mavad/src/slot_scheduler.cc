@@ -0,0 +1,161 @@
+#include "slot_scheduler.h"
+
+rnl::SlotScheduler::SlotScheduler (ns3::Time slot_len, ns3::Time guard, double reuse):
+slot_ns{slot_len.GetNanoSeconds ()}, guard_ns{guard.GetNanoSeconds ()}, reuse_dist{reuse}, grid{reuse}
+{
+    num_slots = 0;
+    changed   = false;
+}
+
+void rnl::SlotScheduler::join (int id)
+{
+    if (id < 0)
+        return;
+    if (static_cast<size_t> (id) >= member.size ())
+    {
+        member.resize (id + 1, 0);
+        slot.resize (id + 1, -1);
+    }
+    changed    = changed || !member[id];
+    member[id] = 1;
+}
+
+void rnl::SlotScheduler::leave (int id)
+{
+    if (!isMember (id))
+        return;
+    member[id] = 0;
+    slot[id]   = -1;
+    changed    = true;
+}
+
+bool rnl::SlotScheduler::isMember (int id) const
+{
+    return id >= 0 && static_cast<size_t> (id) < member.size () && member[id];
+}
+
+bool rnl::SlotScheduler::needsReslot () const
+{
+    return changed;
+}
+
+void rnl::SlotScheduler::reslot (const std::vector<ns3::Vector3D>& pos)
+{
+    /* Members without a position conflict with everyone */
+    const int n = static_cast<int> (member.size ());
+    std::vector<int> unplaced;
+    grid.clear ();
+    for (int i = 0; i < n; ++i)
+    {
+        if (!member[i])
+            continue;
+        if (static_cast<size_t> (i) < pos.size ())
+            grid.update (i, pos[i]);
+        else
+            unplaced.push_back (i);
+    }
+
+    /* Conflict lists in ID order, the unplaced drones have the highest IDs */
+    nb_start.assign (n + 1, 0);
+    nb_list.clear ();
+    for (int i = 0; i < n; ++i)
+    {
+        nb_start[i] = static_cast<int> (nb_list.size ());
+        if (!member[i])
+            continue;
+        if (static_cast<size_t> (i) < pos.size ())
+        {
+            grid.inRange (pos[i], reuse_dist, &near, i);
+            nb_list.insert (nb_list.end (), near.begin (), near.end ());
+            nb_list.insert (nb_list.end (), unplaced.begin (), unplaced.end ());
+        }
+        else
+        {
+            for (int j = 0; j < n; ++j)
+            {
+                if (j != i && member[j])
+                    nb_list.push_back (j);
+            }
+        }
+    }
+    nb_start[n] = static_cast<int> (nb_list.size ());
+
+    std::vector<int> prev (slot);
+    int members = 0;
+    for (size_t i = 0; i < member.size (); ++i)
+    {
+        members += member[i];
+        slot[i]  = -1;
+    }
+
+    /* Keep the previous slot when it is still conflict free, holes left by
+       drones that went away are filled by the next pass */
+    for (int i = 0; i < n; ++i)
+    {
+        if (!member[i] || prev[i] < 0 || prev[i] >= members)
+            continue;
+        bool free = true;
+        for (int k = nb_start[i]; k < nb_start[i + 1] && nb_list[k] < i && free; ++k)
+            free = slot[nb_list[k]] != prev[i];
+        if (free)
+            slot[i] = prev[i];
+    }
+
+    num_slots = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        if (!member[i])
+            continue;
+        if (slot[i] < 0)
+        {
+            taken.assign (members, 0);
+            for (int k = nb_start[i]; k < nb_start[i + 1]; ++k)
+            {
+                if (slot[nb_list[k]] >= 0)
+                    taken[slot[nb_list[k]]] = 1;
+            }
+            int s = 0;
+            while (taken[s])
+                ++s;
+            slot[i] = s;
+        }
+        num_slots = std::max (num_slots, slot[i] + 1);
+    }
+    changed = false;
+}
+
+int rnl::SlotScheduler::slotOf (int id) const
+{
+    return isMember (id) ? slot[id] : -1;
+}
+
+int rnl::SlotScheduler::numSlots () const
+{
+    return num_slots;
+}
+
+ns3::Time rnl::SlotScheduler::frameLength () const
+{
+    return ns3::NanoSeconds (std::max (num_slots, 1) * slot_ns);
+}
+
+int64_t rnl::SlotScheduler::nextStart (int id, int64_t offset, int64_t after) const
+{
+    int64_t frame = std::max (num_slots, 1) * slot_ns;
+    int64_t phase = slot[id] * slot_ns + offset;
+    int64_t k     = (after - phase) / frame;
+    int64_t t     = k * frame + phase;
+    while (t <= after)
+        t += frame;
+    return t;
+}
+
+ns3::Time rnl::SlotScheduler::nextUnicast (int id, ns3::Time after) const
+{
+    return ns3::NanoSeconds (nextStart (id, guard_ns, after.GetNanoSeconds ()));
+}
+
+ns3::Time rnl::SlotScheduler::nextBroadcast (int id, ns3::Time after) const
+{
+    return ns3::NanoSeconds (nextStart (id, slot_ns / 2 + guard_ns, after.GetNanoSeconds ()));
+}
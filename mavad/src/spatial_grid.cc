@@ -0,0 +1,222 @@
+#include "spatial_grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+rnl::SpatialGrid::SpatialGrid (double _cell): cell{_cell > 0 ? _cell : 1.0}
+{
+    count = 0;
+}
+
+int32_t rnl::SpatialGrid::cellCoord (double v) const
+{
+    return static_cast<int32_t> (std::floor (v / cell));
+}
+
+int64_t rnl::SpatialGrid::key (int32_t cx, int32_t cy)
+{
+    return (static_cast<int64_t> (cx) << 32) | static_cast<uint32_t> (cy);
+}
+
+void rnl::SpatialGrid::update (int id, const ns3::Vector3D& p)
+{
+    if (id < 0)
+        return;
+    if (static_cast<size_t> (id) >= pos.size ())
+    {
+        pos.resize (id + 1);
+        cell_of.resize (id + 1, 0);
+        slot_of.resize (id + 1, -1);
+    }
+
+    int64_t _k = key (cellCoord (p.x), cellCoord (p.y));
+    pos[id]    = p;
+    if (slot_of[id] >= 0 && cell_of[id] == _k)
+        return;
+
+    remove (id);
+    pos[id] = p;
+    std::vector<int>& _bucket = cells[_k];
+    cell_of[id] = _k;
+    slot_of[id] = static_cast<int> (_bucket.size ());
+    _bucket.push_back (id);
+    ++count;
+}
+
+void rnl::SpatialGrid::remove (int id)
+{
+    if (!contains (id))
+        return;
+
+    /* Swap with the last drone of the bucket so removal is O(1) */
+    auto _it = cells.find (cell_of[id]);
+    std::vector<int>& _bucket = _it->second;
+    int _last = _bucket.back ();
+    _bucket[slot_of[id]] = _last;
+    slot_of[_last]       = slot_of[id];
+    _bucket.pop_back ();
+    if (_bucket.empty ())
+        cells.erase (_it);
+    slot_of[id] = -1;
+    --count;
+}
+
+void rnl::SpatialGrid::clear ()
+{
+    cells.clear ();
+    std::fill (slot_of.begin (), slot_of.end (), -1);
+    count = 0;
+}
+
+bool rnl::SpatialGrid::contains (int id) const
+{
+    return id >= 0 && static_cast<size_t> (id) < slot_of.size () && slot_of[id] >= 0;
+}
+
+int rnl::SpatialGrid::size () const
+{
+    return count;
+}
+
+double rnl::SpatialGrid::cellSize () const
+{
+    return cell;
+}
+
+void rnl::SpatialGrid::scanCell (int32_t cx, int32_t cy, const ns3::Vector3D& p, double r2, int exclude,
+                                 std::vector<int>* out) const
+{
+    auto _it = cells.find (key (cx, cy));
+    if (_it == cells.end ())
+        return;
+    for (int id : _it->second)
+    {
+        if (id != exclude && ns3::CalculateDistanceSquared (pos[id], p) < r2)
+            out->push_back (id);
+    }
+}
+
+void rnl::SpatialGrid::inRange (const ns3::Vector3D& p, double r, std::vector<int>* out, int exclude) const
+{
+    out->clear ();
+    if (r < 0 || !count)
+        return;
+
+    double  r2 = r * r;
+    int32_t n  = static_cast<int32_t> (std::ceil (r / cell));
+    int32_t cx = cellCoord (p.x);
+    int32_t cy = cellCoord (p.y);
+
+    /* A radius covering more cells than are occupied is cheaper as a walk over the buckets */
+    double _box = (2.0 * n + 1) * (2.0 * n + 1);
+    if (_box > static_cast<double> (cells.size ()))
+    {
+        for (const auto& _c : cells)
+        {
+            for (int id : _c.second)
+            {
+                if (id != exclude && ns3::CalculateDistanceSquared (pos[id], p) < r2)
+                    out->push_back (id);
+            }
+        }
+    }
+    else
+    {
+        for (int32_t x = cx - n; x <= cx + n; ++x)
+            for (int32_t y = cy - n; y <= cy + n; ++y)
+                scanCell (x, y, p, r2, exclude, out);
+    }
+    std::sort (out->begin (), out->end ());
+}
+
+void rnl::SpatialGrid::nearest (const ns3::Vector3D& p, int k, std::vector<int>* out, int exclude) const
+{
+    out->clear ();
+    int _avail = count - (contains (exclude) ? 1 : 0);
+    k = std::min (k, _avail);
+    if (k <= 0)
+        return;
+
+    std::vector<std::pair<double, int>> _cand;
+    std::vector<int> _ring;
+    int32_t cx = cellCoord (p.x);
+    int32_t cy = cellCoord (p.y);
+    double  inf = std::numeric_limits<double>::infinity ();
+
+    /* Walk square rings of cells outwards. Anything beyond ring R is at least R cells away,
+       so once the k-th candidate is that close the search is done */
+    for (int32_t R = 0;; ++R)
+    {
+        _ring.clear ();
+        if ((2.0 * R + 1) * (2.0 * R + 1) > static_cast<double> (cells.size ()))
+        {
+            /* The rings outgrew the occupied cells, take every drone left */
+            _cand.clear ();
+            for (const auto& _c : cells)
+                for (int id : _c.second)
+                    if (id != exclude)
+                        _ring.push_back (id);
+        }
+        else if (R == 0)
+        {
+            scanCell (cx, cy, p, inf, exclude, &_ring);
+        }
+        else
+        {
+            for (int32_t x = cx - R; x <= cx + R; ++x)
+            {
+                scanCell (x, cy - R, p, inf, exclude, &_ring);
+                scanCell (x, cy + R, p, inf, exclude, &_ring);
+            }
+            for (int32_t y = cy - R + 1; y <= cy + R - 1; ++y)
+            {
+                scanCell (cx - R, y, p, inf, exclude, &_ring);
+                scanCell (cx + R, y, p, inf, exclude, &_ring);
+            }
+        }
+        for (int id : _ring)
+            _cand.emplace_back (ns3::CalculateDistanceSquared (pos[id], p), id);
+
+        if (static_cast<int> (_cand.size ()) >= k)
+        {
+            std::nth_element (_cand.begin (), _cand.begin () + (k - 1), _cand.end ());
+            double _reach = R * cell;
+            if (_cand[k - 1].first <= _reach * _reach || static_cast<int> (_cand.size ()) == _avail)
+                break;
+        }
+    }
+
+    std::sort (_cand.begin (), _cand.end ());
+    for (int i = 0; i < k; ++i)
+        out->push_back (_cand[i].second);
+}
+
+void rnl::SpatialGrid::pairsWithin (double r, std::vector<std::pair<int, int>>* out) const
+{
+    out->clear ();
+    if (r < 0)
+        return;
+
+    double  r2 = r * r;
+    int32_t n  = static_cast<int32_t> (std::ceil (r / cell));
+    std::vector<int> _near;
+    for (const auto& _c : cells)
+    {
+        for (int a : _c.second)
+        {
+            int32_t cx = cellCoord (pos[a].x);
+            int32_t cy = cellCoord (pos[a].y);
+            _near.clear ();
+            for (int32_t x = cx - n; x <= cx + n; ++x)
+                for (int32_t y = cy - n; y <= cy + n; ++y)
+                    scanCell (x, y, pos[a], r2, a, &_near);
+            for (int b : _near)
+            {
+                if (a < b)
+                    out->emplace_back (a, b);
+            }
+        }
+    }
+    std::sort (out->begin (), out->end ());
+}
@@ -0,0 +1,104 @@
+#include "swarm_state.h"
+
+rnl::SwarmState::SwarmState ()
+{
+}
+
+void rnl::SwarmState::resize (int n)
+{
+    n = n < 0 ? 0 : n;
+    for (std::vector<double>* _v : {&px, &py, &pz, &lx, &ly, &lz, &ax, &ay, &az})
+    {
+        _v->assign (n, 0.0);
+    }
+    la_s.assign (n, 0.0);
+    la_len.assign (n, -1.0);
+    state.assign (n, 0);
+    control.assign (n, 0);
+    parent.assign (n, -1);
+    anch_id.assign (n, -1);
+    circle_dir.assign (n, 0);
+}
+
+int rnl::SwarmState::size () const
+{
+    return static_cast<int> (px.size ());
+}
+
+ns3::Vector3D rnl::SwarmState::position (int i) const
+{
+    return ns3::Vector3D (px[i], py[i], pz[i]);
+}
+
+void rnl::SwarmState::setPosition (int i, const ns3::Vector3D& p)
+{
+    px[i] = p.x;
+    py[i] = p.y;
+    pz[i] = p.z;
+}
+
+ns3::Vector3D rnl::SwarmState::lookAhead (int i) const
+{
+    return ns3::Vector3D (lx[i], ly[i], lz[i]);
+}
+
+void rnl::SwarmState::setLookAhead (int i, double s, const rnl::Trajectory& traj)
+{
+    la_s[i]   = s;
+    la_len[i] = traj.empty () ? -1.0 : traj.length ();
+    /* Without a path the drone heads nowhere, ie stays where it is */
+    ns3::Vector3D _w = traj.empty () ? position (i) : traj.pointAt (s);
+    lx[i] = _w.x;
+    ly[i] = _w.y;
+    lz[i] = _w.z;
+}
+
+bool rnl::SwarmState::hasPathAhead (int i) const
+{
+    return la_s[i] < la_len[i];
+}
+
+bool rnl::SwarmState::hasPath (int i) const
+{
+    return la_len[i] >= 0;
+}
+
+void rnl::SwarmState::reachedLookAhead (double tol, std::vector<uint8_t>* hit) const
+{
+    const int    n    = size ();
+    const double tol2 = tol * tol;
+    hit->resize (n);
+    uint8_t* _hit = hit->data ();
+    for (int i = 0; i < n; ++i)
+    {
+        double dx = lx[i] - px[i];
+        double dy = ly[i] - py[i];
+        double dz = lz[i] - pz[i];
+        _hit[i] = (la_s[i] < la_len[i]) & (dx * dx + dy * dy + dz * dz < tol2);
+    }
+}
+
+void rnl::SwarmState::positions (std::vector<ns3::Vector3D>* out) const
+{
+    out->resize (size ());
+    for (int i = 0; i < size (); ++i)
+    {
+        (*out)[i] = position (i);
+    }
+}
+
+void rnl::SwarmState::setState (int i, int _state, int _control, int _parent)
+{
+    state[i]   = _state;
+    control[i] = _control;
+    parent[i]  = _parent;
+}
+
+void rnl::SwarmState::setAnchor (int i, int id, const ns3::Vector3D& p, int dir)
+{
+    anch_id[i]    = id;
+    circle_dir[i] = dir;
+    ax[i] = p.x;
+    ay[i] = p.y;
+    az[i] = p.z;
+}
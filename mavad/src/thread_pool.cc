@@ -0,0 +1,110 @@
+#include "thread_pool.h"
+
+rnl::ThreadPool::ThreadPool (int threads)
+{
+    job        = nullptr;
+    job_n      = 0;
+    pending    = 0;
+    generation = 0;
+    stopping   = false;
+    next       = 0;
+    start (threads);
+}
+
+rnl::ThreadPool::~ThreadPool ()
+{
+    stopWorkers ();
+}
+
+void rnl::ThreadPool::start (int threads)
+{
+    stopWorkers ();
+    if (threads <= 0)
+    {
+        threads = static_cast<int> (std::thread::hardware_concurrency ());
+    }
+    stopping = false;
+    for (int i = 1; i < threads; ++i)
+    {
+        workers.emplace_back (&rnl::ThreadPool::work, this, generation);
+    }
+}
+
+void rnl::ThreadPool::stopWorkers ()
+{
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        stopping = true;
+    }
+    cv_start.notify_all ();
+    for (std::thread& _w : workers)
+    {
+        _w.join ();
+    }
+    workers.clear ();
+}
+
+int rnl::ThreadPool::size () const
+{
+    return static_cast<int> (workers.size ()) + 1;
+}
+
+void rnl::ThreadPool::parallelFor (int n, const std::function<void (int)>& fn)
+{
+    if (workers.empty () || n <= 1)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            fn (i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock (mtx);
+        job     = &fn;
+        job_n   = n;
+        next    = 0;
+        pending = static_cast<int> (workers.size ());
+        ++generation;
+    }
+    cv_start.notify_all ();
+
+    runJob ();
+
+    std::unique_lock<std::mutex> lock (mtx);
+    cv_done.wait (lock, [this] { return pending == 0; });
+    job = nullptr;
+}
+
+void rnl::ThreadPool::runJob ()
+{
+    for (int i = next.fetch_add (1); i < job_n; i = next.fetch_add (1))
+    {
+        (*job) (i);
+    }
+}
+
+void rnl::ThreadPool::work (uint64_t seen)
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock (mtx);
+            cv_start.wait (lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+            {
+                return;
+            }
+            seen = generation;
+        }
+
+        runJob ();
+
+        std::lock_guard<std::mutex> lock (mtx);
+        if (--pending == 0)
+        {
+            cv_done.notify_one ();
+        }
+    }
+}
@@ -0,0 +1,19 @@
+/**
+ * @brief Offline converter of a binary packet trace to text
+ */
+
+#include "packet_trace.h"
+
+#include <cstdlib>
+#include <iostream>
+
+int main (int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: " << argv[0] << " <trace.bin> <out.txt> [packets per transfer, 20]" << std::endl;
+        return 1;
+    }
+    uint32_t wrap = argc > 3 ? static_cast<uint32_t> (std::strtoul (argv[3], nullptr, 10)) : 20;
+    return rnl::PacketTrace::exportText (argv[1], argv[2], wrap) ? 0 : 1;
+}
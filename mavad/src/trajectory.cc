@@ -0,0 +1,117 @@
+#include "trajectory.h"
+
+#include <algorithm>
+#include <cmath>
+
+rnl::Trajectory::Trajectory ()
+{
+}
+
+void rnl::Trajectory::clear ()
+{
+    segs.clear ();
+}
+
+void rnl::Trajectory::append (Segment seg)
+{
+    seg.s0 = length ();
+    segs.push_back (seg);
+}
+
+void rnl::Trajectory::hold (const ns3::Vector3D& p)
+{
+    segs.clear ();
+    append (Segment {Kind::LINE, p, p, 0, 0, 0});
+}
+
+void rnl::Trajectory::line (const ns3::Vector3D& from, const ns3::Vector3D& to)
+{
+    if (!empty () && ns3::CalculateDistance (end (), from) > 0)
+    {
+        append (Segment {Kind::LINE, end (), from, 0, 0, ns3::CalculateDistance (end (), from)});
+    }
+    append (Segment {Kind::LINE, from, to, 0, 0, ns3::CalculateDistance (from, to)});
+}
+
+void rnl::Trajectory::polyline (const std::vector<ns3::Vector3D>& pts)
+{
+    for (const ns3::Vector3D& _p : pts)
+    {
+        ns3::Vector3D _from = empty () ? _p : end ();
+        line (_from, _p);
+    }
+}
+
+void rnl::Trajectory::arc (const ns3::Vector3D& centre, double sweep)
+{
+    if (empty ())
+        return;
+    ns3::Vector3D _b = end ();
+    double _r = std::hypot (_b.x - centre.x, _b.y - centre.y);
+    append (Segment {Kind::ARC, ns3::Vector3D (centre.x, centre.y, _b.z), _b, sweep, 0, _r * std::fabs (sweep)});
+}
+
+bool rnl::Trajectory::empty () const
+{
+    return segs.empty ();
+}
+
+double rnl::Trajectory::length () const
+{
+    return segs.empty () ? 0.0 : segs.back ().s0 + segs.back ().len;
+}
+
+int rnl::Trajectory::size () const
+{
+    return static_cast<int> (segs.size ());
+}
+
+ns3::Vector3D rnl::Trajectory::start () const
+{
+    return pointAt (0);
+}
+
+ns3::Vector3D rnl::Trajectory::end () const
+{
+    return pointAt (length ());
+}
+
+const std::vector<rnl::Trajectory::Segment>& rnl::Trajectory::segments () const
+{
+    return segs;
+}
+
+int rnl::Trajectory::segmentAt (double s) const
+{
+    /* First segment ending after s */
+    auto _it = std::upper_bound (segs.begin (), segs.end (), s,
+                                 [] (double v, const Segment& seg) { return v < seg.s0 + seg.len; });
+    return _it == segs.end () ? size () - 1 : static_cast<int> (_it - segs.begin ());
+}
+
+ns3::Vector3D rnl::Trajectory::pointAt (double s) const
+{
+    if (segs.empty ())
+        return ns3::Vector3D ();
+
+    const Segment& seg = segs[segmentAt (s)];
+    double _u = seg.len > 0 ? std::min (std::max ((s - seg.s0) / seg.len, 0.0), 1.0) : 1.0;
+    if (seg.kind == Kind::LINE)
+    {
+        return ns3::Vector3D (seg.a.x + _u * (seg.b.x - seg.a.x),
+                              seg.a.y + _u * (seg.b.y - seg.a.y),
+                              seg.a.z + _u * (seg.b.z - seg.a.z));
+    }
+
+    double _r  = std::hypot (seg.b.x - seg.a.x, seg.b.y - seg.a.y);
+    double _th = std::atan2 (seg.b.y - seg.a.y, seg.b.x - seg.a.x) + _u * seg.sweep;
+    return ns3::Vector3D (seg.a.x + _r * std::cos (_th), seg.a.y + _r * std::sin (_th), seg.a.z);
+}
+
+double rnl::Trajectory::advance (double s, double step) const
+{
+    if (segs.empty ())
+        return 0;
+    const Segment& seg = segs[segmentAt (s)];
+    return std::min (s + step, std::min (seg.s0 + seg.len, length ()));
+}